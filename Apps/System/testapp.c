@@ -11,6 +11,7 @@
 #include "status_bar_layer.h"
 #include "test_defs.h"
 #include "platform_res.h"
+#include "minilib.h"
 
 static Window *s_main_window;
 static Menu *s_menu;
@@ -96,6 +97,97 @@ app_test _tests[] = {
         .test_init = &vibes_test_init,
         .test_execute = &vibes_test_exec,
         .test_deinit = &vibes_test_deinit
+    },
+    {
+        .test_name = "Bitmap Load",
+        .test_desc = "Icon load benchmark",
+        .test_init = &bitmap_load_test_init,
+        .test_execute = &bitmap_load_test_exec,
+        .test_deinit = &bitmap_load_test_deinit
+    },
+    {
+        .test_name = "Heap Bench",
+        .test_desc = "qalloc replay benchmark",
+        .test_init = &heap_bench_test_init,
+        .test_execute = &heap_bench_test_exec,
+        .test_deinit = &heap_bench_test_deinit
+    },
+    {
+        .test_name = "Memory Report",
+        .test_desc = "RTOS heap and stacks",
+        .test_init = &memory_report_test_init,
+        .test_execute = &memory_report_test_exec,
+        .test_deinit = &memory_report_test_deinit
+    },
+    {
+        .test_name = "Draw Bench",
+        .test_desc = "Full redraw benchmark",
+        .test_init = &draw_bench_test_init,
+        .test_execute = &draw_bench_test_exec,
+        .test_deinit = &draw_bench_test_deinit
+    },
+    {
+        .test_name = "Memory Budget",
+        .test_desc = "Leaks and app budget",
+        .test_init = &memory_budget_test_init,
+        .test_execute = &memory_budget_test_exec,
+        .test_deinit = &memory_budget_test_deinit
+    },
+    {
+        .test_name = "Timer Bench",
+        .test_desc = "CoreTimer heap benchmark",
+        .test_init = &timer_bench_test_init,
+        .test_execute = &timer_bench_test_exec,
+        .test_deinit = &timer_bench_test_deinit
+    },
+    {
+        .test_name = "Idle Power",
+        .test_desc = "Idle wakeups and current",
+        .test_init = &idle_power_test_init,
+        .test_execute = &idle_power_test_exec,
+        .test_deinit = &idle_power_test_deinit
+    },
+    {
+        .test_name = "CPU Profile",
+        .test_desc = "Per-task CPU use",
+        .test_init = &cpu_profile_test_init,
+        .test_execute = &cpu_profile_test_exec,
+        .test_deinit = &cpu_profile_test_deinit
+    },
+    {
+        .test_name = "Trace Ring",
+        .test_desc = "Dump scheduler trace",
+        .test_init = &trace_ring_test_init,
+        .test_execute = &trace_ring_test_exec,
+        .test_deinit = &trace_ring_test_deinit
+    },
+    {
+        .test_name = "Event Burst",
+        .test_desc = "Runloop draw coalescing",
+        .test_init = &event_burst_test_init,
+        .test_execute = &event_burst_test_exec,
+        .test_deinit = &event_burst_test_deinit
+    },
+    {
+        .test_name = "Compositor",
+        .test_desc = "Frame cost and damage",
+        .test_init = &compositor_test_init,
+        .test_execute = &compositor_test_exec,
+        .test_deinit = &compositor_test_deinit
+    },
+    {
+        .test_name = "App Registry",
+        .test_desc = "Manifest lookups",
+        .test_init = &app_registry_test_init,
+        .test_execute = &app_registry_test_exec,
+        .test_deinit = &app_registry_test_deinit
+    },
+    {
+        .test_name = "Deferred Work",
+        .test_desc = "ISR to task handoff",
+        .test_init = &deferred_work_test_init,
+        .test_execute = &deferred_work_test_exec,
+        .test_deinit = &deferred_work_test_deinit
     }
 };
 
@@ -104,6 +196,8 @@ static Window *_test_window;
 static AppTimer *_test_exec_timer;
 static app_test *_running_test = NULL;
 static bool _window_initialised = false;
+static TextLayer *_test_output_layer;
+static char _test_output_text[48];
 
 /* Part of the test app's execution mechanism */
 
@@ -197,6 +291,34 @@ bool test_assert_point_is_value(GPoint point, uint8_t value)
     return _test_pass(false, "[ASSERT] FALSE: Point is NOT valid");
 }
 
+/* A results panel for tests that only have some numbers to show. The
+ * test app destroys it once the test has cleaned up */
+TextLayer *test_output_init(Window *window, const char *text)
+{
+    Layer *window_layer = window_get_root_layer(window);
+    GRect bounds = layer_get_bounds(window_layer);
+
+    _test_output_layer = text_layer_create(GRect(0, 56, bounds.size.w, 60));
+    text_layer_set_text_alignment(_test_output_layer, GTextAlignmentCenter);
+    layer_add_child(window_layer, text_layer_get_layer(_test_output_layer));
+    text_layer_set_text(_test_output_layer, text);
+
+    return _test_output_layer;
+}
+
+void test_output(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (!_test_output_layer)
+        return;
+
+    va_start(ap, fmt);
+    vsfmt(_test_output_text, sizeof(_test_output_text), fmt, ap);
+    va_end(ap);
+    text_layer_set_text(_test_output_layer, _test_output_text);
+}
+
 /* The test's running Click handlers */
 
 /*
@@ -245,6 +367,9 @@ static void testapp_exec_window_unload(Window *window)
 {
     SYS_LOG("tstapp", APP_LOG_LEVEL_ERROR, "Test Cleanup");
     _running_test->test_deinit(_test_window);
+    if (_test_output_layer)
+        text_layer_destroy(_test_output_layer);
+    _test_output_layer = NULL;
 
     SYS_LOG("tstapp", APP_LOG_LEVEL_ERROR, "[%s] Test Complete: %s",
             _running_test->success ? "PASS" : "FAIL", _running_test->test_name);
@@ -0,0 +1,70 @@
+/* app_registry_test.c
+ * Look every app in the manifest up by name and by UUID, and time it
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+
+#define APP_REGISTRY_ROUNDS 1000
+
+bool app_registry_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: App Registry Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool app_registry_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: App Registry Test");
+
+    uint32_t apps = 0, lookups = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    for (uint16_t round = 0; round < APP_REGISTRY_ROUNDS; round++)
+    {
+        for (App *app = app_manager_get_apps_head(); app; app = app->next)
+        {
+            if (round == 0)
+                apps++;
+
+            /* names needn't be unique, so it may find another of the same */
+            App *found = appmanager_get_app(app->name);
+            test_assert(found && !strcmp(found->name, app->name));
+            lookups++;
+
+            /* the baked in apps are only known by name */
+            if (app->is_internal)
+                continue;
+
+            test_assert(appmanager_get_app_by_uuid(&app->uuid) == app);
+            lookups++;
+        }
+    }
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+
+    /* and something that isn't there */
+    Uuid nobody;
+    memset(&nobody, 0xA5, sizeof(Uuid));
+    test_assert(appmanager_get_app_by_uuid(&nobody) == NULL);
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "%d apps: %d lookups in %dms",
+            apps, lookups, elapsed * portTICK_PERIOD_MS);
+
+    test_output("%d apps\n%d lookups: %dms", apps, lookups, elapsed * portTICK_PERIOD_MS);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool app_registry_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: App Registry Test");
+    return true;
+}
@@ -0,0 +1,105 @@
+/* bitmap_load_test.c
+ * Benchmark the time taken to load the bundled system icons as build-time
+ * native GBitmaps, and in a BITMAP_BENCH build from the PNGs they were made from
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "platform_res.h"
+
+/* How many times each icon is loaded. Loads are short, so we need a few
+ * iterations to rise above the tick granularity */
+#define BITMAP_LOAD_ITERATIONS 20
+
+/* RES_GBITMAP_all in config.mk converts these. Only a BITMAP_BENCH build
+ * keeps the PNGs as well, so otherwise there is nothing to compare with */
+#ifdef BITMAP_BENCH
+#define ICON(res) { res, res##_PNG }
+#else
+#define ICON(res) { res, 0 }
+#endif
+
+static const uint32_t _icons[][2] = {
+    ICON(RESOURCE_ID_CLOCK),
+    ICON(RESOURCE_ID_SPANNER),
+    ICON(RESOURCE_ID_SPEECH_BUBBLE),
+    ICON(RESOURCE_ID_MUSIC_PLAY),
+    ICON(RESOURCE_ID_MUSIC_PAUSE),
+    ICON(RESOURCE_ID_ALARM_BELL_RINGING),
+};
+
+#define ICON_COUNT (sizeof(_icons) / sizeof(_icons[0]))
+#define ICON_NATIVE 0
+#define ICON_PNG    1
+
+static TickType_t _load(uint32_t resource_id, GSize *size)
+{
+    TickType_t start = xTaskGetTickCount();
+    
+    for (uint8_t n = 0; n < BITMAP_LOAD_ITERATIONS; n++)
+    {
+        GBitmap *bitmap = gbitmap_create_with_resource(resource_id);
+        if (!test_assert_point_is_not_null(bitmap))
+            break;
+        *size = gbitmap_get_bounds(bitmap).size;
+        /* the pixels should be movable, so compaction can work around them */
+        test_assert(bitmap->data_handle != NULL);
+        gbitmap_destroy(bitmap);
+    }
+    
+    return xTaskGetTickCount() - start;
+}
+
+bool bitmap_load_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Bitmap Load Test");
+    test_output_init(window, "Loading...");
+
+    return true;
+}
+
+bool bitmap_load_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Bitmap Load Test");
+    TickType_t total[2] = { 0, 0 };
+
+    for (uint8_t i = 0; i < ICON_COUNT; i++)
+    {
+        GSize native_size = GSize(0, 0), png_size = GSize(0, 0);
+        TickType_t native = _load(_icons[i][ICON_NATIVE], &native_size);
+        TickType_t png = 0;
+        
+        /* both ways should give the same picture */
+        if (_icons[i][ICON_PNG])
+        {
+            png = _load(_icons[i][ICON_PNG], &png_size);
+            test_assert(native_size.w == png_size.w && native_size.h == png_size.h);
+        }
+        
+        total[ICON_NATIVE] += native;
+        total[ICON_PNG] += png;
+        SYS_LOG("test", APP_LOG_LEVEL_INFO, "Res %d: %d loads, native %dms, png %dms",
+                _icons[i][ICON_NATIVE], BITMAP_LOAD_ITERATIONS,
+                native * portTICK_PERIOD_MS, png * portTICK_PERIOD_MS);
+    }
+    
+    test_output("%d icons\nnative %dms\npng %dms",
+                ICON_COUNT * BITMAP_LOAD_ITERATIONS, total[ICON_NATIVE] * portTICK_PERIOD_MS,
+                total[ICON_PNG] * portTICK_PERIOD_MS);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Bitmap load: %d icons, native %dms, png %dms",
+            ICON_COUNT * BITMAP_LOAD_ITERATIONS, total[ICON_NATIVE] * portTICK_PERIOD_MS,
+            total[ICON_PNG] * portTICK_PERIOD_MS);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool bitmap_load_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Bitmap Load Test");
+    return true;
+}
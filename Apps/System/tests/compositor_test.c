@@ -0,0 +1,81 @@
+/* compositor_test.c
+ * Time frames through the compositor and count the context switches
+ * each one costs, and check that clean frames cost nothing
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "compositor.h"
+#include "overlay_manager.h"
+
+#define COMPOSITOR_FRAMES 20
+
+static Window *_main_window;
+
+static uint32_t _switches(void)
+{
+    return (uint32_t)pvTaskGetThreadLocalStoragePointer(NULL, DEBUG_TLS_SWITCHES);
+}
+
+bool compositor_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Compositor Test");
+    _main_window = window;
+    test_output_init(window, "Composing...");
+
+    return true;
+}
+
+bool compositor_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Compositor Test");
+
+    compositor_stats_t before, after;
+    Layer *root = window_get_root_layer(_main_window);
+
+    /* damaged frames */
+    compositor_get_stats(&before);
+    uint32_t switches = _switches();
+    uint32_t start = debug_runtime_counter();
+    for (uint16_t i = 0; i < COMPOSITOR_FRAMES; i++)
+    {
+        layer_mark_dirty(root);
+        window_draw();
+    }
+    uint32_t elapsed = debug_runtime_counter() - start;
+    switches = _switches() - switches;
+    compositor_get_stats(&after);
+
+    uint32_t frames = after.frames - before.frames;
+    uint32_t overlay_draws = after.overlay_draws - before.overlay_draws;
+    test_assert(frames == COMPOSITOR_FRAMES);
+    test_assert(after.app_draws - before.app_draws == COMPOSITOR_FRAMES);
+    /* with no overlays up, the overlay thread is left out of it */
+    if (overlay_window_count() == 0)
+        test_assert(overlay_draws == 0);
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "%d frames: %dus each, %d switches, %d overlay passes",
+            frames, elapsed / COMPOSITOR_FRAMES, switches, overlay_draws);
+
+    /* and clean ones, which shouldn't reach the display at all */
+    compositor_get_stats(&before);
+    for (uint16_t i = 0; i < COMPOSITOR_FRAMES; i++)
+        window_draw();
+    compositor_get_stats(&after);
+    test_assert(after.frames == before.frames);
+
+    test_output("%dus/frame\n%d switches", elapsed / COMPOSITOR_FRAMES, switches);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool compositor_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Compositor Test");
+    return true;
+}
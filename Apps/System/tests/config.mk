@@ -8,3 +8,16 @@ SRCS_all += Apps/System/tests/menu_simple_test.c
 SRCS_all += Apps/System/tests/menu_multi_column_test.c
 SRCS_all += Apps/System/tests/action_menu_test.c
 SRCS_all += Apps/System/tests/vibes_test.c
+SRCS_all += Apps/System/tests/bitmap_load_test.c
+SRCS_all += Apps/System/tests/heap_bench_test.c
+SRCS_all += Apps/System/tests/memory_report_test.c
+SRCS_all += Apps/System/tests/draw_bench_test.c
+SRCS_all += Apps/System/tests/memory_budget_test.c
+SRCS_all += Apps/System/tests/timer_bench_test.c
+SRCS_all += Apps/System/tests/idle_power_test.c
+SRCS_all += Apps/System/tests/cpu_profile_test.c
+SRCS_all += Apps/System/tests/trace_ring_test.c
+SRCS_all += Apps/System/tests/event_burst_test.c
+SRCS_all += Apps/System/tests/compositor_test.c
+SRCS_all += Apps/System/tests/app_registry_test.c
+SRCS_all += Apps/System/tests/deferred_work_test.c
@@ -0,0 +1,80 @@
+/* cpu_profile_test.c
+ * Log each task's share of the CPU, context switches and stack headroom,
+ * having kept the CPU busy for a known part of the time
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+
+#define CPU_PROFILE_BUSY_MS 250
+#define CPU_PROFILE_IDLE_MS 750
+
+static uint32_t _switches(void)
+{
+    return (uint32_t)pvTaskGetThreadLocalStoragePointer(NULL, DEBUG_TLS_SWITCHES);
+}
+
+static uint32_t _runtime(void)
+{
+    TaskStatus_t status;
+    vTaskGetInfo(NULL, &status, pdFALSE, eRunning);
+    return status.ulRunTimeCounter;
+}
+
+bool cpu_profile_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: CPU Profile Test");
+    test_output_init(window, "Profiling...");
+
+    return true;
+}
+
+bool cpu_profile_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: CPU Profile Test");
+
+    /* start the log's interval from here */
+    task_cpu_log();
+
+    uint32_t start = debug_runtime_counter();
+    uint32_t runtime = _runtime();
+    uint32_t switches = _switches();
+
+    TickType_t busy = xTaskGetTickCount();
+    while (xTaskGetTickCount() - busy < pdMS_TO_TICKS(CPU_PROFILE_BUSY_MS))
+        ;
+    vTaskDelay(pdMS_TO_TICKS(CPU_PROFILE_IDLE_MS));
+
+    uint32_t elapsed = debug_runtime_counter() - start;
+    runtime = _runtime() - runtime;
+    switches = _switches() - switches;
+
+    task_cpu_log();
+
+    /* the clock has to keep up with the tick, sleeping or not, and
+     * we must have had at least the busy part to ourselves */
+    uint32_t expected = (CPU_PROFILE_BUSY_MS + CPU_PROFILE_IDLE_MS) * 1000;
+    test_assert(elapsed > expected * 9 / 10 && elapsed < expected * 11 / 10);
+    test_assert(runtime >= CPU_PROFILE_BUSY_MS * 1000 * 9 / 10 && runtime < elapsed);
+    /* and been switched back in after the delay at the very least */
+    test_assert(switches >= 1);
+
+    uint32_t percent = (uint64_t)runtime * 100 / elapsed;
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Test task: %d%% of %dms, %d switches",
+            percent, elapsed / 1000, switches);
+
+    test_output("%d%% CPU\n%d switches", percent, switches);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool cpu_profile_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: CPU Profile Test");
+    return true;
+}
@@ -0,0 +1,78 @@
+/* deferred_work_test.c
+ * Push work through the deferred queue and see it all run, in order, and
+ * how long it waited
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "deferred.h"
+
+#define DEFERRED_WORK_CALLS 100
+
+static volatile uint32_t _ran;
+static volatile uint32_t _out_of_order;
+static volatile uint32_t _max_wait_us;
+
+/* value is when it was queued */
+static void _work(void *arg, uint32_t value)
+{
+    uint32_t wait = debug_runtime_counter() - value;
+
+    if ((uint32_t)arg != _ran)
+        _out_of_order++;
+    if (wait > _max_wait_us)
+        _max_wait_us = wait;
+    _ran++;
+}
+
+bool deferred_work_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Deferred Work Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool deferred_work_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Deferred Work Test");
+
+    _ran = 0;
+    _out_of_order = 0;
+    _max_wait_us = 0;
+
+    /* the worker outranks us, so each call should run as soon as it's
+     * queued; the ring never gets the chance to fill */
+    uint32_t queued = 0;
+    for (uint32_t i = 0; i < DEFERRED_WORK_CALLS; i++)
+        queued += deferred_call_from_isr(_work, (void *)i, debug_runtime_counter());
+
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    test_assert(queued == DEFERRED_WORK_CALLS);
+    test_assert(_ran == queued);
+    test_assert(_out_of_order == 0);
+
+    deferred_stats_t stats;
+    deferred_get_stats(&stats);
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Deferred: %d of %d ran, longest wait %dus",
+            _ran, DEFERRED_WORK_CALLS, _max_wait_us);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Deferred: %d queued, %d dropped, %d of %d slots at most",
+            stats.queued, stats.dropped, stats.high_water, DEFERRED_QUEUE_SIZE);
+
+    test_output("%d calls\nwait <= %dus", _ran, _max_wait_us);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool deferred_work_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Deferred Work Test");
+    return true;
+}
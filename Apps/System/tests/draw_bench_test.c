@@ -0,0 +1,99 @@
+/* draw_bench_test.c
+ * Time full redraws of a draw-heavy window, to compare builds with
+ * different CCRAM placement
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "display.h"
+
+#define DRAW_BENCH_FRAMES 50
+
+static Window *_main_window;
+static Layer *_draw_layer;
+static uint16_t _frame;
+
+/* A bit of everything: fills, outlines, lines, circles and text */
+static void _draw_layer_update_proc(Layer *layer, GContext *ctx)
+{
+    GRect bounds = layer_get_bounds(layer);
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        int16_t inset = (i * 4 + _frame) % (bounds.size.h / 2);
+        graphics_context_set_fill_color(ctx, i & 1 ? GColorBlack : GColorWhite);
+        graphics_fill_rect(ctx, GRect(inset, inset, bounds.size.w - inset * 2,
+                                      bounds.size.h - inset * 2), 0, GCornerNone);
+    }
+
+    graphics_context_set_stroke_color(ctx, GColorBlack);
+    for (int16_t x = 0; x < bounds.size.w; x += 8)
+        graphics_draw_line(ctx, GPoint(x, 0), GPoint(bounds.size.w - x, bounds.size.h));
+
+    for (uint8_t r = 8; r < bounds.size.w / 2; r += 12)
+        graphics_draw_circle(ctx, GPoint(bounds.size.w / 2, bounds.size.h / 2), r);
+
+    graphics_context_set_text_color(ctx, GColorBlack);
+    graphics_draw_text(ctx, "The quick brown fox jumps over the lazy dog",
+                       fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+                       GRect(4, 4, bounds.size.w - 8, bounds.size.h - 8),
+                       GTextOverflowModeWordWrap, GTextAlignmentLeft, 0);
+}
+
+bool draw_bench_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Draw Bench Test");
+    _main_window = window;
+    Layer *window_layer = window_get_root_layer(window);
+    GRect bounds = layer_get_bounds(window_layer);
+
+    _draw_layer = layer_create(bounds);
+    layer_set_update_proc(_draw_layer, _draw_layer_update_proc);
+    layer_add_child(window_layer, _draw_layer);
+
+    test_output_init(window, "Drawing...");
+
+    return true;
+}
+
+bool draw_bench_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Draw Bench Test");
+
+    /* draw straight into the framebuffer; nobody else may touch it meanwhile */
+    if (!test_assert(display_buffer_lock_take(500)))
+    {
+        test_complete(false);
+        return false;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    for (_frame = 0; _frame < DRAW_BENCH_FRAMES; _frame++)
+    {
+        /* every frame is new, so nothing is replayed from a display list */
+        layer_mark_dirty(_draw_layer);
+        rbl_window_draw(_main_window);
+    }
+    TickType_t elapsed = xTaskGetTickCount() - start;
+
+    display_buffer_lock_give();
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Draw: %d frames in %dms",
+            DRAW_BENCH_FRAMES, elapsed * portTICK_PERIOD_MS);
+
+    test_output("%d frames: %dms", DRAW_BENCH_FRAMES, elapsed * portTICK_PERIOD_MS);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool draw_bench_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Draw Bench Test");
+    layer_destroy(_draw_layer);
+    return true;
+}
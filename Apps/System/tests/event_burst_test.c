@@ -0,0 +1,99 @@
+/* event_burst_test.c
+ * Post a burst of button events that each mark the window dirty, and
+ * check the runloop handles them all but only draws the once
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+
+/* One short of the app queue depth, so a draw or tick that is already
+ * queued doesn't stall the burst. We count what made it in anyway */
+#define EVENT_BURST_SIZE 4
+
+static TextLayer *_output_layer;
+
+static ButtonMessage _messages[EVENT_BURST_SIZE];
+static uint16_t _posted;
+static uint16_t _handled;
+static app_runloop_stats_t _before;
+static uint32_t _runtime_before;
+
+static uint32_t _runtime(void)
+{
+    TaskStatus_t status;
+    vTaskGetInfo(NULL, &status, pdFALSE, eRunning);
+    return status.ulRunTimeCounter;
+}
+
+static void _burst_click_handler(ClickRecognizerRef recognizer, void *context)
+{
+    _handled++;
+    layer_mark_dirty(text_layer_get_layer(_output_layer));
+}
+
+/* By now the burst has been through the runloop */
+static void _check_callback(void *data)
+{
+    app_runloop_stats_t after;
+    appmanager_app_runloop_get_stats(&after);
+    uint32_t runtime = _runtime() - _runtime_before;
+
+    uint32_t events = after.events - _before.events;
+    uint32_t frames = after.frames - _before.frames;
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Burst of %d: %d posted, %d handled, %d events, %d frames, %dus CPU",
+            EVENT_BURST_SIZE, _posted, _handled, events, frames, runtime);
+
+    test_assert(_posted > 0);
+    test_assert(_handled == _posted);
+    test_assert(events >= _posted);
+    /* one for the burst, and perhaps one for the iteration that posted it */
+    test_assert(frames >= 1 && frames <= 2);
+
+    test_output("%d events\n%d frames", events, frames);
+
+    test_complete(test_get_success());
+}
+
+bool event_burst_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Event Burst Test");
+    /* each click dirties it, which is what makes the frames */
+    _output_layer = test_output_init(window, "Bursting...");
+
+    return true;
+}
+
+bool event_burst_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Event Burst Test");
+
+    _posted = 0;
+    _handled = 0;
+    appmanager_app_runloop_get_stats(&_before);
+    _runtime_before = _runtime();
+
+    /* we are called from the runloop, so these all queue up behind us */
+    for (uint16_t i = 0; i < EVENT_BURST_SIZE; i++)
+    {
+        _messages[i].callback = _burst_click_handler;
+        _messages[i].clickref = NULL;
+        _messages[i].context = NULL;
+        if (appmanager_post_button_message(&_messages[i]))
+            _posted++;
+    }
+
+    app_timer_register(200, (AppTimerCallback)_check_callback, NULL);
+
+    return true;
+}
+
+bool event_burst_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Event Burst Test");
+    return true;
+}
@@ -0,0 +1,312 @@
+/* heap_bench_test.c
+ * Time qalloc/qfree replaying app-like and notification-like workloads,
+ * scratch buffers and UI objects from the heap against the frame arena
+ * and object pools, and compaction of movable blocks
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "qalloc.h"
+
+/* The arena we benchmark in is carved out of the test app's own heap */
+#define HEAP_BENCH_ARENA_SIZE 6000
+#define HEAP_BENCH_SLOTS 48
+#define HEAP_BENCH_OPS 4000
+
+typedef enum {
+    HeapBenchApp,
+    HeapBenchNotification,
+} HeapBenchWorkload;
+
+static uint32_t _seed;
+
+static uint32_t _rand(void)
+{
+    _seed = _seed * 1103515245 + 12345;
+    return (_seed >> 16) & 0x7FFF;
+}
+
+/*
+ * Sizes seen from the UI: lots of small layer and text objects,
+ * the odd window, and now and again a bitmap
+ */
+static uint16_t _app_size(void)
+{
+    uint32_t r = _rand() % 100;
+    if (r < 50)
+        return 24 + _rand() % 48;      /* Layer, TextLayer, small strings */
+    if (r < 80)
+        return 80 + _rand() % 120;     /* Window, MenuLayer, buffers */
+    if (r < 97)
+        return 200 + _rand() % 300;    /* cell arrays, text */
+    return 1024 + _rand() % 1024;      /* bitmaps */
+}
+
+/* Notification messages come and go roughly in order */
+static uint16_t _notification_size(void)
+{
+    return 40 + _rand() % 460;
+}
+
+static TickType_t _replay(void *heap, HeapBenchWorkload workload, uint16_t *failed)
+{
+    void *slots[HEAP_BENCH_SLOTS] = { 0 };
+    qarena_t *arena = qinit(heap, HEAP_BENCH_ARENA_SIZE);
+    uint16_t oldest = 0, newest = 0;
+
+    _seed = 1;
+    *failed = 0;
+
+    TickType_t start = xTaskGetTickCount();
+
+    for (uint16_t op = 0; op < HEAP_BENCH_OPS; op++)
+    {
+        uint16_t i;
+        bool release;
+
+        if (workload == HeapBenchApp)
+        {
+            /* random lifetimes */
+            i = _rand() % HEAP_BENCH_SLOTS;
+            release = slots[i] != NULL;
+        }
+        else if (newest == oldest ||
+                 (newest - oldest < HEAP_BENCH_SLOTS / 2 && (_rand() & 1)))
+        {
+            /* a new message arrives */
+            i = newest++ % HEAP_BENCH_SLOTS;
+            release = false;
+        }
+        else
+        {
+            /* the oldest one is dismissed */
+            i = oldest++ % HEAP_BENCH_SLOTS;
+            release = true;
+        }
+
+        if (release)
+        {
+            qfree(arena, slots[i]);
+            slots[i] = NULL;
+            continue;
+        }
+
+        slots[i] = qalloc(arena, workload == HeapBenchApp ? _app_size() : _notification_size());
+        if (!slots[i])
+            (*failed)++;
+    }
+
+    for (uint16_t i = 0; i < HEAP_BENCH_SLOTS; i++)
+        qfree(arena, slots[i]);
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+
+    /* everything is free again, so it should all have merged back */
+    void *all = qalloc(arena, HEAP_BENCH_ARENA_SIZE / 2);
+    test_assert_point_is_not_null(all);
+    qfree(arena, all);
+
+    return elapsed;
+}
+
+/*
+ * Fill the arena with movable blocks, free every other one, and check a
+ * block bigger than any of the holes fits once the heap is compacted
+ */
+static void _compact(void *heap)
+{
+    qarena_t *arena = qinit(heap, HEAP_BENCH_ARENA_SIZE);
+    qhandle_t handles[QALLOC_NHANDLES] = { 0 };
+    uint16_t n;
+
+    for (n = 0; n < QALLOC_NHANDLES; n++)
+    {
+        handles[n] = qhalloc(arena, 300);
+        if (!handles[n])
+            break;
+        memset(qhlock(handles[n]), n, 300);
+        qhunlock(handles[n]);
+    }
+
+    for (uint16_t i = 0; i < n; i += 2)
+    {
+        qhfree(arena, handles[i]);
+        handles[i] = NULL;
+    }
+
+    if (!test_assert(n > 2))
+        return;
+
+    /* pin one, it has to stay where it is */
+    void *pinned = qhlock(handles[1]);
+
+    TickType_t start = xTaskGetTickCount();
+    unsigned largest = qcompact(arena);
+    TickType_t elapsed = xTaskGetTickCount() - start;
+
+    test_assert(largest >= 900);
+    test_assert(handles[1]->ptr == pinned);
+    test_assert_point_is_not_null(qalloc(arena, 900));
+
+    /* and everything that moved kept its contents */
+    for (uint16_t i = 1; i < n; i += 2)
+    {
+        uint8_t *p = qhlock(handles[i]);
+        test_assert(p[0] == i && p[299] == i);
+        qhunlock(handles[i]);
+    }
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Compact: %d handles, largest free %d in %dms",
+            n, largest, elapsed * portTICK_PERIOD_MS);
+}
+
+/*
+ * Scratch buffers the way a decoder uses them, nested three deep,
+ * first from the heap and then from the frame arena
+ */
+static void _scratch(TickType_t *heap, TickType_t *frame)
+{
+    TickType_t start = xTaskGetTickCount();
+    for (uint16_t op = 0; op < HEAP_BENCH_OPS / 3; op++)
+    {
+        void *a = app_malloc(1152);
+        void *b = app_malloc(576);
+        void *c = app_malloc(576);
+        app_free(c);
+        app_free(b);
+        app_free(a);
+    }
+    *heap = xTaskGetTickCount() - start;
+
+    start = xTaskGetTickCount();
+    for (uint16_t op = 0; op < HEAP_BENCH_OPS / 3; op++)
+    {
+        frame_mark_t mark = app_frame_mark();
+        app_frame_alloc(1152);
+        app_frame_alloc(576);
+        app_frame_alloc(576);
+        app_frame_release(mark);
+    }
+    *frame = xTaskGetTickCount() - start;
+
+    /* everything was released, so the arena is back where it started */
+    frame_mark_t before = app_frame_mark();
+    test_assert_point_is_not_null(app_frame_alloc(1152));
+    app_frame_release(before);
+    frame_mark_t after = app_frame_mark();
+    test_assert(before.top == after.top && before.overflow == after.overflow);
+}
+
+/*
+ * Small app_malloc/app_free pairs, as a UI building layers does. This is
+ * mostly the cost of finding the calling thread's heap
+ */
+static TickType_t _small_allocs(void)
+{
+    TickType_t start = xTaskGetTickCount();
+    for (uint16_t op = 0; op < HEAP_BENCH_OPS; op++)
+        app_free(app_malloc(32));
+
+    return xTaskGetTickCount() - start;
+}
+
+/*
+ * Tear down and rebuild a screen's worth of layers, as apps do on
+ * every screen transition
+ */
+#define HEAP_BENCH_UI_LAYERS 8
+
+static TickType_t _ui_churn(void)
+{
+    Layer *layers[HEAP_BENCH_UI_LAYERS];
+    TextLayer *text_layers[HEAP_BENCH_UI_LAYERS];
+
+    TickType_t start = xTaskGetTickCount();
+    for (uint16_t op = 0; op < HEAP_BENCH_OPS / HEAP_BENCH_UI_LAYERS; op++)
+    {
+        for (uint8_t i = 0; i < HEAP_BENCH_UI_LAYERS; i++)
+        {
+            layers[i] = layer_create(GRect(0, 0, 10, 10));
+            text_layers[i] = text_layer_create(GRect(0, 0, 10, 10));
+        }
+        for (uint8_t i = 0; i < HEAP_BENCH_UI_LAYERS; i++)
+        {
+            text_layer_destroy(text_layers[i]);
+            layer_destroy(layers[i]);
+        }
+    }
+
+    return xTaskGetTickCount() - start;
+}
+
+bool heap_bench_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Heap Bench Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool heap_bench_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Heap Bench Test");
+
+    void *heap = app_calloc(1, HEAP_BENCH_ARENA_SIZE);
+    if (!test_assert_point_is_not_null(heap))
+    {
+        test_complete(false);
+        return false;
+    }
+
+    uint16_t app_failed, notif_failed;
+    TickType_t app = _replay(heap, HeapBenchApp, &app_failed);
+    TickType_t notif = _replay(heap, HeapBenchNotification, &notif_failed);
+    _compact(heap);
+
+    app_free(heap);
+
+    TickType_t scratch_heap, scratch_frame;
+    _scratch(&scratch_heap, &scratch_frame);
+    TickType_t small = _small_allocs();
+
+    /* the pools last as long as the app, so on a second run both
+     * passes are pooled and the reserves fail harmlessly */
+    TickType_t ui_heap = _ui_churn();
+    layer_pool_reserve(HEAP_BENCH_UI_LAYERS);
+    text_layer_pool_reserve(HEAP_BENCH_UI_LAYERS);
+    TickType_t ui_pool = _ui_churn();
+
+    /* and how the test app's own heap is doing */
+    heap_stats_t stats;
+    if (test_assert(heap_stats(HeapApp, &stats)))
+    {
+        test_assert(stats.used <= stats.peak && stats.peak <= stats.size);
+        heap_stats_log(HeapApp);
+    }
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "App: %d ops in %dms, %d failed",
+            HEAP_BENCH_OPS, app * portTICK_PERIOD_MS, app_failed);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Notification: %d ops in %dms, %d failed",
+            HEAP_BENCH_OPS, notif * portTICK_PERIOD_MS, notif_failed);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Small: %d app_malloc/app_free in %dms",
+            HEAP_BENCH_OPS, small * portTICK_PERIOD_MS);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "UI churn: heap %dms, pooled %dms",
+            ui_heap * portTICK_PERIOD_MS, ui_pool * portTICK_PERIOD_MS);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Scratch: heap %dms, frame %dms",
+            scratch_heap * portTICK_PERIOD_MS, scratch_frame * portTICK_PERIOD_MS);
+
+    test_output("App: %dms\nNotif: %dms", app * portTICK_PERIOD_MS, notif * portTICK_PERIOD_MS);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool heap_bench_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Heap Bench Test");
+    return true;
+}
@@ -0,0 +1,88 @@
+/* idle_power_test.c
+ * Sit idle for a while and see how often the core woke up, and roughly
+ * what it would have drawn doing so
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "power.h"
+
+#define IDLE_POWER_SECONDS 10
+
+/* Rough typical STM32F4 core currents at 100MHz from the datasheet.
+ * Only good for comparing one build against another */
+#define IDLE_POWER_RUN_UA   20000
+#define IDLE_POWER_SLEEP_UA 6000
+#define IDLE_POWER_STOP_UA  300
+
+static AppTimer *_idle_timer;
+static power_sleep_stats_t _before;
+static TickType_t _start;
+
+/* The runloop has had nothing to do but wait for us. Blocking in exec
+ * instead would look like a hung app to the watchdog */
+static void _idle_done_callback(void *data)
+{
+    /* fired timers are only freed by a cancel */
+    app_timer_cancel(_idle_timer);
+    _idle_timer = NULL;
+    
+    power_sleep_stats_t after;
+    power_get_sleep_stats(&after);
+    TickType_t elapsed = xTaskGetTickCount() - _start;
+
+    uint32_t sleeps = after.sleeps - _before.sleeps;
+    uint32_t slept = after.ticks_slept - _before.ticks_slept;
+    uint32_t stopped = after.ticks_stopped - _before.ticks_stopped;
+    test_assert(slept <= elapsed && stopped <= slept);
+
+    /* every tick we were awake for interrupted the core, as did the end
+     * of every sleep */
+    uint32_t awake = elapsed - slept;
+    uint32_t wakeups = (sleeps + awake) * 60 / IDLE_POWER_SECONDS;
+    uint32_t current = (awake * IDLE_POWER_RUN_UA +
+                        (slept - stopped) * IDLE_POWER_SLEEP_UA +
+                        stopped * IDLE_POWER_STOP_UA) / elapsed;
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Idle %ds: %d sleeps (%d in STOP), %d of %d ticks slept, %d stopped",
+            IDLE_POWER_SECONDS, sleeps, after.stops - _before.stops, slept, elapsed, stopped);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "Idle: %d wakeups/min, about %duA",
+            wakeups, current);
+
+    test_output("%d wakeups/min\n~%duA", wakeups, current);
+
+    test_complete(test_get_success());
+}
+
+bool idle_power_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Idle Power Test");
+    test_output_init(window, "Idling...");
+
+    return true;
+}
+
+bool idle_power_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Idle Power Test");
+
+    power_get_sleep_stats(&_before);
+    _start = xTaskGetTickCount();
+    _idle_timer = app_timer_register(IDLE_POWER_SECONDS * 1000,
+                                     (AppTimerCallback)_idle_done_callback, NULL);
+
+    return true;
+}
+
+bool idle_power_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Idle Power Test");
+    if (_idle_timer)
+        app_timer_cancel(_idle_timer);
+    _idle_timer = NULL;
+    return true;
+}
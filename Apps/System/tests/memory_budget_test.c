@@ -0,0 +1,105 @@
+/* memory_budget_test.c
+ * Replay some typical UI and notification work and check the heaps come
+ * back to where they were, and that the test app stays in its budget
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "notification_message.h"
+
+#define MEMORY_BUDGET_ROUNDS 10
+
+/* What a system app does when it opens a screen and closes it again */
+static void _screen(void)
+{
+    Window *window = window_create();
+    if (!test_assert_point_is_not_null(window))
+        return;
+
+    GRect bounds = GRect(0, 0, DISPLAY_COLS, DISPLAY_ROWS);
+    MenuLayer *menu = menu_layer_create(bounds);
+    StatusBarLayer *status_bar = status_bar_layer_create();
+    TextLayer *title = text_layer_create(GRect(0, 0, bounds.size.w, 20));
+    GBitmap *icon = gbitmap_create_with_resource(RESOURCE_ID_SPEECH_BUBBLE);
+
+    gbitmap_destroy(icon);
+    text_layer_destroy(title);
+    status_bar_layer_destroy(status_bar);
+    menu_layer_destroy(menu);
+    window_destroy(window);
+}
+
+/* and a notification arriving and being dismissed */
+static void _notification(void)
+{
+    full_msg_t *msg = message_create();
+    if (test_assert_point_is_not_null(msg))
+        message_destroy(msg);
+}
+
+static void _round(void)
+{
+    _screen();
+    _notification();
+}
+
+/*
+ * Anything an arena holds after a round that it didn't hold before is
+ * a leak; log and fail on it
+ */
+static bool _steady(HeapId heap, heap_stats_t *before)
+{
+    heap_stats_t after;
+    if (!heap_stats(heap, &after))
+        return true;
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "%s heap: steady %d, peak %d",
+            heap_stats_name(heap), after.used, after.peak);
+
+    return test_assert(after.used == before->used);
+}
+
+bool memory_budget_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Memory Budget Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool memory_budget_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Memory Budget Test");
+
+    /* the first round fills caches and slabs that are kept for later */
+    _round();
+
+    heap_stats_t app, notification;
+    test_assert(heap_stats(HeapApp, &app));
+    test_assert(heap_stats(HeapNotification, &notification));
+
+    for (uint16_t i = 0; i < MEMORY_BUDGET_ROUNDS; i++)
+        _round();
+
+    _steady(HeapApp, &app);
+    _steady(HeapNotification, &notification);
+
+    size_t footprint = app_memory_footprint();
+    test_assert(footprint <= MEMORY_BUDGET_SYSTEM_APP);
+    test_assert(app_memory_check_budget());
+
+    test_output("Peak: %d\nBudget: %d", footprint, MEMORY_BUDGET_SYSTEM_APP);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool memory_budget_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Memory Budget Test");
+    return true;
+}
@@ -0,0 +1,44 @@
+/* memory_report_test.c
+ * Log the RTOS heap, task stack headroom and app heaps
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+
+bool memory_report_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Memory Report Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool memory_report_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Memory Report Test");
+
+    memory_report_log();
+
+    /* if the heap ever ran dry, the malloc failed hook would have hung us */
+    size_t least_free = xPortGetMinimumEverFreeHeapSize();
+    test_assert(least_free > 0 && least_free <= xPortGetFreeHeapSize());
+
+    /* nothing should have got within a few words of the end of its stack */
+    UBaseType_t headroom = uxTaskGetStackHighWaterMark(NULL);
+    test_assert(headroom > 16);
+
+    test_output("Least free: %d\nStack left: %d", least_free, headroom);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool memory_report_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Memory Report Test");
+    return true;
+}
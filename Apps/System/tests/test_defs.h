@@ -125,6 +125,28 @@ bool test_assert_point_is_color(GPoint point, GColor color);
  */
 bool test_assert_point_is_value(GPoint point, uint8_t value);
 
+/**
+ * @brief Give the test a results panel
+ *
+ * For tests that only have some numbers to show. Puts a centred text
+ * layer of up to three lines in the middle of the window. The test app
+ * destroys it after the test's deinit.
+ * @param window the window the test was given in init
+ * @param text what to show until there are results
+ * @return the \ref TextLayer, if the test wants to do more with it
+ */
+TextLayer *test_output_init(Window *window, const char *text);
+
+/**
+ * @brief Show results in the panel from \ref test_output_init
+ *
+ * printf style, and formatted into a buffer the test app owns
+ * @code
+ * test_output("%d frames\n%dms", frames, ms);
+ * @endcode
+ */
+void test_output(const char *fmt, ...);
+
 /* Test declarions for various tests */
 bool test_test_init(Window *window);
 bool test_test_exec(void);
@@ -153,3 +175,55 @@ bool action_menu_test_deinit(void);
 bool vibes_test_init(Window *window);
 bool vibes_test_exec(void);
 bool vibes_test_deinit(void);
+
+bool bitmap_load_test_init(Window *window);
+bool bitmap_load_test_exec(void);
+bool bitmap_load_test_deinit(void);
+
+bool heap_bench_test_init(Window *window);
+bool heap_bench_test_exec(void);
+bool heap_bench_test_deinit(void);
+
+bool memory_report_test_init(Window *window);
+bool memory_report_test_exec(void);
+bool memory_report_test_deinit(void);
+
+bool draw_bench_test_init(Window *window);
+bool draw_bench_test_exec(void);
+bool draw_bench_test_deinit(void);
+
+bool memory_budget_test_init(Window *window);
+bool memory_budget_test_exec(void);
+bool memory_budget_test_deinit(void);
+
+bool timer_bench_test_init(Window *window);
+bool timer_bench_test_exec(void);
+bool timer_bench_test_deinit(void);
+
+bool idle_power_test_init(Window *window);
+bool idle_power_test_exec(void);
+bool idle_power_test_deinit(void);
+
+bool cpu_profile_test_init(Window *window);
+bool cpu_profile_test_exec(void);
+bool cpu_profile_test_deinit(void);
+
+bool trace_ring_test_init(Window *window);
+bool trace_ring_test_exec(void);
+bool trace_ring_test_deinit(void);
+
+bool event_burst_test_init(Window *window);
+bool event_burst_test_exec(void);
+bool event_burst_test_deinit(void);
+
+bool compositor_test_init(Window *window);
+bool compositor_test_exec(void);
+bool compositor_test_deinit(void);
+
+bool app_registry_test_init(Window *window);
+bool app_registry_test_exec(void);
+bool app_registry_test_deinit(void);
+
+bool deferred_work_test_init(Window *window);
+bool deferred_work_test_exec(void);
+bool deferred_work_test_deinit(void);
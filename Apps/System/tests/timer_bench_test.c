@@ -0,0 +1,125 @@
+/* timer_bench_test.c
+ * Time adding, cancelling and expiring lots of CoreTimers, and check
+ * they come off the heap in order
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+
+#define TIMER_BENCH_COUNT 500
+#define TIMER_BENCH_ROUNDS 10
+
+static uint32_t _seed;
+
+static uint32_t _rand(void)
+{
+    _seed = _seed * 1103515245 + 12345;
+    return (_seed >> 16) & 0x7FFF;
+}
+
+/* none of ours should ever get as far as firing */
+static void _timer_callback(CoreTimer *timer)
+{
+    test_assert(!"bench timer fired");
+}
+
+typedef struct TimerBenchTimes {
+    TickType_t add;
+    TickType_t cancel;
+    TickType_t expire;
+} TimerBenchTimes;
+
+/*
+ * Every round adds count timers, cancels every other one and then takes
+ * the rest off the top of the heap as if they had expired.
+ * Their deadlines are all in the first few seconds after boot, so they
+ * sort ahead of any real timer the test app has running
+ */
+static void _run(CoreTimer *timers, uint16_t count, TimerBenchTimes *times)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+
+    memset(times, 0, sizeof(TimerBenchTimes));
+    _seed = 1;
+
+    for (uint16_t round = 0; round < TIMER_BENCH_ROUNDS; round++)
+    {
+        TickType_t start = xTaskGetTickCount();
+        for (uint16_t i = 0; i < count; i++)
+        {
+            timers[i].when = _rand() % 1000;
+            timers[i].callback = _timer_callback;
+            appmanager_timer_add(&timers[i]);
+        }
+        times->add += xTaskGetTickCount() - start;
+
+        start = xTaskGetTickCount();
+        for (uint16_t i = 0; i < count; i += 2)
+            appmanager_timer_remove(&timers[i]);
+        times->cancel += xTaskGetTickCount() - start;
+
+        TickType_t last = 0;
+        start = xTaskGetTickCount();
+        for (uint16_t i = 1; i < count; i += 2)
+        {
+            CoreTimer *timer = thread->timer_head;
+            if (!test_assert(timer >= timers && timer < timers + count))
+                break;
+            test_assert(timer->when >= last);
+            last = timer->when;
+            appmanager_timer_remove(timer);
+        }
+        times->expire += xTaskGetTickCount() - start;
+    }
+}
+
+bool timer_bench_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Timer Bench Test");
+    test_output_init(window, "Running...");
+
+    return true;
+}
+
+bool timer_bench_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Timer Bench Test");
+
+    CoreTimer *timers = app_calloc(TIMER_BENCH_COUNT, sizeof(CoreTimer));
+    if (!test_assert_point_is_not_null(timers))
+    {
+        test_complete(false);
+        return false;
+    }
+
+    /* a tenth as many first, then the lot. Per timer, the cost should
+     * hardly change */
+    TimerBenchTimes few, many;
+    _run(timers, TIMER_BENCH_COUNT / 10, &few);
+    _run(timers, TIMER_BENCH_COUNT, &many);
+
+    app_free(timers);
+
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "%d timers x%d: add %dms, cancel %dms, expire %dms",
+            TIMER_BENCH_COUNT / 10, TIMER_BENCH_ROUNDS, few.add * portTICK_PERIOD_MS,
+            few.cancel * portTICK_PERIOD_MS, few.expire * portTICK_PERIOD_MS);
+    SYS_LOG("test", APP_LOG_LEVEL_INFO, "%d timers x%d: add %dms, cancel %dms, expire %dms",
+            TIMER_BENCH_COUNT, TIMER_BENCH_ROUNDS, many.add * portTICK_PERIOD_MS,
+            many.cancel * portTICK_PERIOD_MS, many.expire * portTICK_PERIOD_MS);
+
+    test_output("%d timers\n%dms",
+                TIMER_BENCH_COUNT, (many.add + many.cancel + many.expire) * portTICK_PERIOD_MS);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool timer_bench_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Timer Bench Test");
+    return true;
+}
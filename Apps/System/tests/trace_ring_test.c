@@ -0,0 +1,58 @@
+/* trace_ring_test.c
+ * Put a few marks and a context switch in the trace ring and dump it,
+ * for Utilities/trace_decode.py to turn into a timeline
+ * libRebbleOS
+ */
+
+#include "rebbleos.h"
+#include "systemapp.h"
+#include "menu.h"
+#include "status_bar_layer.h"
+#include "test_defs.h"
+#include "trace.h"
+
+#define TRACE_RING_MARKS 4
+
+bool trace_ring_test_init(Window *window)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Init: Trace Ring Test");
+    test_output_init(window, "Tracing...");
+
+    return true;
+}
+
+bool trace_ring_test_exec(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "Exec: Trace Ring Test");
+
+    uint32_t before = trace_record_count();
+
+    for (uint8_t i = 0; i < TRACE_RING_MARKS; i++)
+    {
+        TRACE_MARK(i, 0);
+        /* sleeping switches us out and back in again */
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    uint32_t recorded = trace_record_count() - before;
+
+#ifdef TRACE_RING_RECORDS
+    /* every mark, and a switch away and back for each sleep */
+    test_assert(recorded >= TRACE_RING_MARKS * 3);
+#else
+    test_assert(recorded == 0);
+#endif
+
+    trace_dump();
+
+    test_output("%d records\nin the log", recorded);
+
+    test_complete(test_get_success());
+    return true;
+}
+
+bool trace_ring_test_deinit(void)
+{
+    SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "De-Init: Trace Ring Test");
+    return true;
+}
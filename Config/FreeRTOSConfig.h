@@ -97,11 +97,14 @@
 #define configUSE_TICK_HOOK    1
 #define configCPU_CLOCK_HZ    ( SystemCoreClock )
 #define configTICK_RATE_HZ    ( ( TickType_t ) 200 )
-#define configMAX_PRIORITIES   ( 5 )
+/* Apps, the app manager, buttons and the watchdog share priority 4 and
+ * time slice. 5 is only for the deferred work task, so work handed off
+ * by interrupts runs ahead of all of them */
+#define configMAX_PRIORITIES   ( 6 )
 #define configMINIMAL_STACK_SIZE  ( ( unsigned short ) 180 )
 #define configTOTAL_HEAP_SIZE   ( ( size_t ) ( RTOS_HEAP_SIZE ) )
 #define configMAX_TASK_NAME_LEN   ( 10 )
-#define configUSE_TRACE_FACILITY  0
+#define configUSE_TRACE_FACILITY  1
 #define configUSE_16_BIT_TICKS   0
 #define configIDLE_SHOULD_YIELD   1
 #define configUSE_MUTEXES    1
@@ -111,10 +114,45 @@
 #define configUSE_MALLOC_FAILED_HOOK 1
 #define configUSE_APPLICATION_TASK_TAG 0
 #define configUSE_COUNTING_SEMAPHORES 1
-#define configGENERATE_RUN_TIME_STATS 0
+#define configGENERATE_RUN_TIME_STATS 1
 #define configUSE_TASK_NOTIFICATIONS            1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 2
+/* Where a platform sets configUSE_TICKLESS_IDLE, waking back up costs
+ * enough that gaps shorter than this aren't worth sleeping through */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 4
 //#define portBYTE_ALIGNMENT 4
 
+/* Run time stats are kept in microseconds, counted off the DWT cycle
+ * counter, and each task counts how often it has been switched in in its
+ * second thread local storage slot. Both are cheap enough to leave on;
+ * see debug.c */
+#define DEBUG_TLS_SWITCHES 1
+extern void debug_runtime_init(void);
+extern uint32_t debug_runtime_counter(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() debug_runtime_init()
+#define portGET_RUN_TIME_COUNTER_VALUE() debug_runtime_counter()
+
+/* With TRACE_RING_RECORDS set, switches and queue traffic also go into
+ * the trace ring; see trace.h */
+#ifdef TRACE_RING_RECORDS
+#include "trace.h"
+#define _TRACE_SWITCHED_IN() trace_record_event( TraceTaskSwitchedIn, pxCurrentTCB->uxTCBNumber, 0 )
+#define traceQUEUE_SEND( pxQueue ) trace_record_event( TraceQueueSend, 0, TRACE_QUEUE( pxQueue ) )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue ) trace_record_event( TraceQueueSendFromIsr, 0, TRACE_QUEUE( pxQueue ) )
+#define traceQUEUE_RECEIVE( pxQueue ) trace_record_event( TraceQueueReceive, 0, TRACE_QUEUE( pxQueue ) )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue ) trace_record_event( TraceQueueReceiveFromIsr, 0, TRACE_QUEUE( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue ) trace_record_event( TraceQueueBlockSend, 0, TRACE_QUEUE( pxQueue ) )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) trace_record_event( TraceQueueBlockReceive, 0, TRACE_QUEUE( pxQueue ) )
+#else
+#define _TRACE_SWITCHED_IN()
+#endif
+
+#define traceTASK_SWITCHED_IN() do { \
+    pxCurrentTCB->pvThreadLocalStoragePointers[ DEBUG_TLS_SWITCHES ] = \
+        ( void * ) ( ( uint32_t ) pxCurrentTCB->pvThreadLocalStoragePointers[ DEBUG_TLS_SWITCHES ] + 1 ); \
+    _TRACE_SWITCHED_IN(); \
+} while ( 0 )
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES   0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -135,6 +173,7 @@
 #define INCLUDE_vTaskDelayUntil   1
 #define INCLUDE_vTaskDelay    1
 #define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -31,6 +31,9 @@ can (aspirationally):
     PNG.
   * Convert a graphic to system framebuffer format, for use as a splash
     screen.
+  * Convert a PNG to the native GBitmap format at build time (see
+    convert_png_to_gbitmap), so that the watch does not have to inflate and
+    unfilter it every time it is loaded.
 """
 
 __author__ = "Joshua Wise <joshua@joshuawise.com>"
@@ -38,10 +41,28 @@ __author__ = "Joshua Wise <joshua@joshuawise.com>"
 from stm32_crc import crc32
 import struct
 import json
+import zlib
+import copy
 
 TAB_OFS = 0x0C
 RES_OFS = 0x200C
 
+# Native bitmap resource format.  This must match GBitmapNativeHeader in
+# rwatch/graphics/gbitmap.h.
+GBITMAP_NATIVE_MAGIC = b"RBMP"
+GBITMAP_NATIVE_VERSION = 1
+GBITMAP_NATIVE_HDR = '<4sBBHHHHH'
+
+# GBitmapFormat, from rwatch/graphics/gbitmap.h.
+GBITMAP_FORMAT_8BIT = 1
+GBITMAP_FORMAT_1BIT_PALETTE = 2
+GBITMAP_FORMAT_2BIT_PALETTE = 3
+GBITMAP_FORMAT_4BIT_PALETTE = 4
+
+# Rows are padded out to a word, so that the loader and blitter never have
+# to do unaligned row accesses.
+GBITMAP_NATIVE_ROW_ALIGN = 4
+
 def load_resource_from_pbpack(fname, resid):
     """
     Returns resource number |resid| from the pbpack file specified by
@@ -71,6 +92,172 @@ def load_resource_from_disk(fname):
     with open(fname, 'rb') as f:
         return f.read()
 
+def decode_png(data):
+    """
+    Decodes a non-interlaced PNG into a list of rows, each of which is a
+    list of (r, g, b, a) tuples.
+    
+    We only need this to be good enough for the images that we ship, so it
+    understands greyscale, truecolour and palette images (with or without
+    tRNS), but not Adam7 interlacing or 16-bit channels.
+    """
+    
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG")
+    
+    ofs = 8
+    idat = b""
+    plte = []
+    trns = b""
+    while ofs < len(data):
+        (ln, typ) = struct.unpack('>I4s', data[ofs:ofs + 8])
+        chunk = data[ofs + 8:ofs + 8 + ln]
+        ofs += 12 + ln
+        if typ == b"IHDR":
+            (w, h, depth, ctype, _, _, interlace) = struct.unpack('>IIBBBBB', chunk)
+        elif typ == b"PLTE":
+            plte = [tuple(bytearray(chunk[i:i + 3])) for i in range(0, len(chunk), 3)]
+        elif typ == b"tRNS":
+            trns = bytearray(chunk)
+        elif typ == b"IDAT":
+            idat += chunk
+        elif typ == b"IEND":
+            break
+    
+    if interlace != 0:
+        raise ValueError("interlaced PNGs are not supported")
+    if depth > 8:
+        raise ValueError("16-bit PNGs are not supported")
+    
+    chans = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    bpp = max(1, chans * depth // 8)
+    stride = (w * chans * depth + 7) // 8
+    raw = bytearray(zlib.decompress(idat))
+    
+    rows = []
+    prev = bytearray(stride)
+    for y in range(h):
+        ftype = raw[y * (stride + 1)]
+        line = raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)]
+        for x in range(stride):
+            a = line[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+            if ftype == 1:
+                line[x] = (line[x] + a) & 0xFF
+            elif ftype == 2:
+                line[x] = (line[x] + b) & 0xFF
+            elif ftype == 3:
+                line[x] = (line[x] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                (pa, pb, pc) = (abs(p - a), abs(p - b), abs(p - c))
+                pred = a if (pa <= pb and pa <= pc) else (b if pb <= pc else c)
+                line[x] = (line[x] + pred) & 0xFF
+        prev = line
+        
+        # Unpack samples, then turn them into RGBA.
+        if depth < 8:
+            per = 8 // depth
+            samples = [(line[i // per] >> (8 - depth * (i % per + 1))) & ((1 << depth) - 1) for i in range(w * chans)]
+        else:
+            samples = list(line)
+        
+        row = []
+        for x in range(w):
+            px = samples[x * chans:(x + 1) * chans]
+            if ctype == 3:
+                (r, g, b) = plte[px[0]]
+                a = trns[px[0]] if px[0] < len(trns) else 255
+            elif ctype == 0:
+                v = px[0] * 255 // ((1 << depth) - 1)
+                (r, g, b) = (v, v, v)
+                a = 0 if (len(trns) >= 2 and px[0] == struct.unpack('>H', bytes(trns[0:2]))[0]) else 255
+            elif ctype == 2:
+                (r, g, b) = px
+                a = 0 if (len(trns) >= 6 and tuple(px) == struct.unpack('>HHH', bytes(trns[0:6]))) else 255
+            elif ctype == 4:
+                (r, g, b, a) = (px[0], px[0], px[0], px[1])
+            else:
+                (r, g, b, a) = px
+            row.append((r, g, b, a))
+        rows.append(row)
+    
+    return rows
+
+def convert_png_to_gbitmap(data, bw = False):
+    """
+    Converts a PNG into the native GBitmap resource format, which is laid
+    out as:
+    
+      * a GBitmapNativeHeader (magic, version, format, row_size_bytes,
+        width, height, palette_size, and padding);
+      * the pixel data, row_size_bytes * height bytes, packed MSB-first
+        exactly as upng would have left it in memory;
+      * the palette, palette_size GColor8 (ARGB2222) entries.
+    
+    Colours are crushed to GColor8 here rather than on the watch, and the
+    smallest palettized format that can hold the image is chosen.  Images
+    with more than 16 colours are stored as GColor8 pixels, with no
+    palette; GBitmap's palette_size couldn't count to 256 anyway.
+    
+    If |bw| is set, the image is for a black and white display, and every
+    pixel is crushed to black, white or clear instead.  That always fits
+    in a 1- or 2-bit palette, so there is no point shipping more.
+    """
+    
+    rows = decode_png(data)
+    h = len(rows)
+    w = len(rows[0]) if h else 0
+    
+    def argb8(px):
+        (r, g, b, a) = px
+        if bw:
+            if a < 128:
+                return 0x00
+            return 0xFF if (r * 299 + g * 587 + b * 114) // 1000 >= 128 else 0xC0
+        return ((a >> 6) << 6) | ((r >> 6) << 4) | ((g >> 6) << 2) | (b >> 6)
+    
+    palette = []
+    palidx = {}
+    idxrows = []
+    for row in rows:
+        idxrow = []
+        for px in row:
+            c = argb8(px)
+            if c not in palidx:
+                palidx[c] = len(palette)
+                palette.append(c)
+            idxrow.append(palidx[c])
+        idxrows.append(idxrow)
+    
+    if len(palette) <= 2:
+        (fmt, bpp) = (GBITMAP_FORMAT_1BIT_PALETTE, 1)
+    elif len(palette) <= 4:
+        (fmt, bpp) = (GBITMAP_FORMAT_2BIT_PALETTE, 2)
+    elif len(palette) <= 16:
+        (fmt, bpp) = (GBITMAP_FORMAT_4BIT_PALETTE, 4)
+    else:
+        (fmt, bpp) = (GBITMAP_FORMAT_8BIT, 8)
+        idxrows = [[palette[i] for i in idxrow] for idxrow in idxrows]
+        palette = []
+    
+    row_size_bytes = (w * bpp + 7) // 8
+    row_size_bytes = (row_size_bytes + GBITMAP_NATIVE_ROW_ALIGN - 1) & ~(GBITMAP_NATIVE_ROW_ALIGN - 1)
+    
+    pixels = bytearray()
+    for idxrow in idxrows:
+        line = bytearray(row_size_bytes)
+        for (x, i) in enumerate(idxrow):
+            bit = x * bpp
+            line[bit // 8] |= i << (8 - bpp - (bit % 8))
+        pixels += line
+    
+    hdr = struct.pack(GBITMAP_NATIVE_HDR, GBITMAP_NATIVE_MAGIC, GBITMAP_NATIVE_VERSION, fmt,
+                      row_size_bytes, w, h, len(palette), 0)
+    
+    return hdr + bytes(pixels) + bytes(bytearray(palette))
+
 def save_pbpack(fname, rsrcs):
     """
     Outputs a handful of resources to a file.
@@ -125,6 +312,20 @@ class Resource(object):
     def __init__(self, coll, j):
         self.coll = coll
         self.name = j["name"]
+        self.convert = j.get("convert", None)
+        
+        if self.convert not in (None, "gbitmap"):
+            raise ValueError("unknown conversion {} for resource {}".format(self.convert, self.name))
+    
+    def output(self):
+        """
+        The resource data as it should appear in the pack, after any
+        requested conversion.
+        """
+        
+        if self.convert == "gbitmap":
+            return convert_png_to_gbitmap(self.data(), bw = self.coll.bw)
+        return self.data()
 
 class ResourceRef(Resource):
     def __init__(self, coll, j):
@@ -180,10 +381,14 @@ class ResourceCollection:
             key, with a filename; if "resource", then there should be a
             "ref" key, with a reference from "references" above, and an "id"
             key, with a resource ID to load from that reference.
+          
+          * "convert" (optional): set to "gbitmap" to convert a PNG input
+            into the native GBitmap format at build time.  The loader on
+            the watch recognizes these by their header, and skips decoding.
     
     """
 
-    def __init__(self, fname, root = "."):
+    def __init__(self, fname, root = ".", gbitmaps = [], keep_png = False, bw = False):
         """
         Load in a resource collection from a file, but don't load the
         resources associated with it.  (That happens later.)
@@ -191,6 +396,7 @@ class ResourceCollection:
         
         self.jfname = fname
         self.root = root
+        self.bw = bw
         
         with open(fname, 'r') as f:
             jdb = json.load(f)
@@ -208,6 +414,23 @@ class ResourceCollection:
                 self.resources.append(ResourceRef(self, res))
             else:
                 raise ValueError("unknown resource type {}".format(res["type"]))
+        
+        # Resources converted on request from the command line.  If asked,
+        # the PNG each came from goes on the end of the pack, after
+        # everything else so no IDs move, for anything that wants to
+        # compare the two.  That is only for benchmarking; a release pack
+        # has no use for two copies of every icon.
+        byname = {r.name: r for r in self.resources}
+        for name in gbitmaps:
+            if name not in byname:
+                print("warning: no resource {} to convert to a GBitmap".format(name))
+                continue
+            byname[name].convert = "gbitmap"
+            if keep_png:
+                png = copy.copy(byname[name])
+                png.name = "{}_PNG".format(name)
+                png.convert = None
+                self.resources.append(png)
     
     def deps(self):
         """
@@ -225,7 +448,7 @@ class ResourceCollection:
         List of raw resource data in this resource pack.
         """
         
-        return [r.data() for r in self.resources]
+        return [r.output() for r in self.resources]
     
     def write_pbpack(self, fname):
         """
@@ -249,7 +472,8 @@ class ResourceCollection:
             f.write("\n")
             f.write("typedef enum resource_id {\n")
             for (rid, r) in enumerate(self.resources):
-                f.write("    {} = {}, /* (from {}) */\n".format(r.name, rid + 1, r.sourcedesc()))
+                f.write("    {} = {}, /* (from {}{}) */\n".format(r.name, rid + 1, r.sourcedesc(),
+                                                              ", as native GBitmap" if r.convert else ""))
             f.write("} resource_id;\n")
     
     def write_makedeps(self, fname, rsrcfile, hdrfile):
@@ -284,11 +508,14 @@ def main():
     parser.add_argument("-M", "--make-dep", action="store_true", default = False, help = "produce a .d file to be included by 'make'")
     parser.add_argument("-H", "--header", action = "store_true", default = False, help = "produce a .h file to be included in C source")
     parser.add_argument("-P", "--pbpack", action = "store_true", default = False, help = "produce a .pbpack file")
+    parser.add_argument("-g", "--gbitmap", action = "append", default = [], help = "convert the named PNG resource to a native GBitmap (may be repeated)")
+    parser.add_argument("-k", "--keep-png", action = "store_true", default = False, help = "also keep the PNG of each -g resource, as <name>_PNG")
+    parser.add_argument("-b", "--bw", action = "store_true", default = False, help = "convert -g resources for a black and white display")
     parser.add_argument("json", help = "input JSON configuration file")
     parser.add_argument("basename", help = "base output name ('.d', '.h', and '.pbpack' are appended automatically)")
     args = parser.parse_args()
     
-    rc = ResourceCollection(args.json, root = args.root[0])
+    rc = ResourceCollection(args.json, root = args.root[0], gbitmaps = args.gbitmap, keep_png = args.keep_png, bw = args.bw)
     
     pbpack_name = "{}.pbpack".format(args.basename)
     header_name = "{}.h".format(args.basename)
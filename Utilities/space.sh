@@ -5,12 +5,43 @@ getsym() {
 	grep " $1 =" $MAP | awk '{ print $1 }'
 }
 
-FLASH_REMAIN=$(($(getsym _flash_top) - ($(getsym _edata) - $(getsym _sdata) + $(getsym _erodata))))
+# List the objects placed in CCRAM, largest first. ld wraps long input
+# section names onto their own line, with the address and size on the next
+ccram_objects() {
+	awk '
+		/^\.ccm/ { in_ccm = 1; next }
+		/^\.[a-zA-Z]/ || /^\/DISCARD\// { in_ccm = 0 }
+		!in_ccm { next }
+		$1 ~ /^\.ccm/ && NF == 1 { pending = 1; next }
+		pending && NF >= 3 { print $2, $3; pending = 0; next }
+		$1 ~ /^\.ccm/ && NF >= 4 { print $3, $4 }
+	' $MAP | while read SIZE OBJ; do
+		[[ $((SIZE)) -gt 0 ]] && printf "%8d  %s\n" $((SIZE)) $OBJ
+	done | sort -rn
+}
+
+CCRAM_INIT=0
+if [[ $(getsym _eccmidata) ]]; then
+  CCRAM_INIT=$(($(getsym _eccmidata) - $(getsym _sccmidata)))
+fi
+
+FLASH_REMAIN=$(($(getsym _flash_top) - ($(getsym _edata) - $(getsym _sdata) + $(getsym _erodata) + $CCRAM_INIT)))
 RAM_REMAIN=$(($(getsym _ram_top) - $(getsym _end)))
 
 if [[ $(getsym _ccm_top) ]]; then
-  CCRAM_REMAIN=$(($(getsym _ccm_top) - $(getsym _eccmidata)))
+  CCRAM_ZERO=0
+  CCRAM_END=$(getsym _eccmidata)
+  if [[ $(getsym _eccmbss) ]]; then
+    CCRAM_ZERO=$(($(getsym _eccmbss) - $(getsym _sccmbss)))
+    CCRAM_END=$(getsym _eccmbss)
+  fi
+  CCRAM_REMAIN=$(($(getsym _ccm_top) - $CCRAM_END))
+  echo "CCRAM: $CCRAM_INIT bytes initialised, $CCRAM_ZERO bytes zeroed:"
+  ccram_objects
   echo "$CCRAM_REMAIN bytes of CCRAM available."
+  if [[ $CCRAM_REMAIN -lt 1024 ]]; then
+    echo "warning: CCRAM nearly full, move the next stack or heap to SRAM."
+  fi
 fi
 
 echo "$RAM_REMAIN bytes of RAM available for heap."
@@ -0,0 +1,180 @@
+#!/usr/bin/env python
+
+"""
+Decodes a trace ring dump (trace_dump() in rcore/trace.c) from a debug
+log into a readable timeline, or into Chrome trace JSON that
+chrome://tracing or ui.perfetto.dev can load.
+RebbleOS
+
+Only the lines containing "trace: " are looked at, so a whole serial log
+can be fed in as is. If it holds several dumps, the last one is used.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+# Keep in step with trace_event in rcore/trace.h
+EVENTS = {
+    1: "switch",
+    2: "queue send",
+    3: "queue send (isr)",
+    4: "queue receive",
+    5: "queue receive (isr)",
+    6: "block on send",
+    7: "block on receive",
+    8: "isr enter",
+    9: "isr exit",
+    10: "mark",
+}
+TASK_SWITCHED_IN = 1
+ISR_ENTER = 8
+ISR_EXIT = 9
+MARK = 10
+
+SRAM_BASE = 0x20000000
+
+parser = argparse.ArgumentParser(description = "Trace ring decoder for RebbleOS.")
+parser.add_argument("-c", "--chrome", action = "store_true", help = "write Chrome trace JSON rather than a timeline")
+parser.add_argument("-H", "--histogram", action = "store_true", help = "write a histogram of time spent in each interrupt")
+parser.add_argument("-o", "--output", default = None, help = "output file (default stdout)")
+parser.add_argument("log", nargs = "?", default = None, help = "debug log containing a dump (default stdin)")
+args = parser.parse_args()
+
+def parse(lines):
+    tasks = {}
+    records = []
+    for line in lines:
+        m = re.search(r"trace: (\w+) ?(.*)$", line)
+        if not m:
+            continue
+        kind, rest = m.group(1), m.group(2).strip()
+        if kind == "begin":
+            tasks = {}
+            records = []
+        elif kind == "task":
+            number, name = rest.split(" ", 1)
+            tasks[int(number)] = name
+        elif kind == "rec":
+            for i in range(0, len(rest), 16):
+                rec = rest[i:i + 16]
+                if len(rec) < 16:
+                    break
+                records.append((int(rec[0:8], 16), int(rec[8:10], 16),
+                                int(rec[10:12], 16), int(rec[12:16], 16)))
+    return tasks, unwrap(records)
+
+def unwrap(records):
+    """The microsecond clock is 32 bits and wraps after about 71 minutes"""
+    out = []
+    base = 0
+    last = None
+    for time, event, arg, value in records:
+        if last is not None and time < last:
+            base += 1 << 32
+        last = time
+        out.append((base + time, event, arg, value))
+    return out
+
+def task_name(tasks, number):
+    return tasks.get(number, "task %d" % number)
+
+def isr_name(exception):
+    if exception < 16:
+        return "exception %d" % exception
+    return "IRQ %d" % (exception - 16)
+
+def queue_name(value):
+    return "queue 0x%08x" % (SRAM_BASE + (value << 2))
+
+def describe(tasks, event, arg, value):
+    name = EVENTS.get(event, "event %d" % event)
+    if event == TASK_SWITCHED_IN:
+        return "%s -> %s" % (name, task_name(tasks, arg))
+    if event in (ISR_ENTER, ISR_EXIT):
+        return "%s %s" % (name, isr_name(arg))
+    if event == MARK:
+        return "%s %d %d" % (name, arg, value)
+    return "%s %s" % (name, queue_name(value))
+
+def timeline(tasks, records, out):
+    if not records:
+        return
+    start = records[0][0]
+    last = start
+    for time, event, arg, value in records:
+        out.write("%12.3fms %+9dus  %s\n" % ((time - start) / 1000.0, time - last,
+                                           describe(tasks, event, arg, value)))
+        last = time
+
+def chrome(tasks, records, out):
+    """Tasks share one track, as they share the one core; interrupts get a
+    track of their own above it, and queue traffic shows as instants"""
+    events = []
+    running = None
+    start = records[0][0] if records else 0
+    for time, event, arg, value in records:
+        ts = time - start
+        if event == TASK_SWITCHED_IN:
+            if running is not None:
+                events.append({"name": task_name(tasks, running), "ph": "E", "ts": ts, "pid": 0, "tid": 1})
+            running = arg
+            events.append({"name": task_name(tasks, arg), "ph": "B", "ts": ts, "pid": 0, "tid": 1})
+        elif event in (ISR_ENTER, ISR_EXIT):
+            events.append({"name": isr_name(arg), "ph": "B" if event == ISR_ENTER else "E",
+                           "ts": ts, "pid": 0, "tid": 0})
+        else:
+            events.append({"name": describe(tasks, event, arg, value), "ph": "i", "s": "t",
+                           "ts": ts, "pid": 0, "tid": 1})
+    if running is not None:
+        events.append({"name": task_name(tasks, running), "ph": "E",
+                       "ts": records[-1][0] - start, "pid": 0, "tid": 1})
+    events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": 0, "args": {"name": "Interrupts"}})
+    events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": 1, "args": {"name": "Tasks"}})
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, out, indent = 1)
+    out.write("\n")
+
+def histogram(tasks, records, out):
+    """How long each interrupt took, entry to exit, in power of two
+    microsecond buckets. Time spent in a nested interrupt counts towards
+    the one it interrupted too"""
+    durations = {}
+    entered = []
+    for time, event, arg, value in records:
+        if event == ISR_ENTER:
+            entered.append((arg, time))
+        elif event == ISR_EXIT and entered:
+            # the ring may have started part way through one
+            while entered and entered[-1][0] != arg:
+                entered.pop()
+            if entered:
+                durations.setdefault(arg, []).append(time - entered.pop()[1])
+    for exception in sorted(durations):
+        times = durations[exception]
+        out.write("%s: %d calls, mean %dus, max %dus\n" % (isr_name(exception), len(times),
+                                                           sum(times) // len(times), max(times)))
+        buckets = {}
+        for t in times:
+            bucket = 1
+            while bucket < t:
+                bucket <<= 1
+            buckets[bucket] = buckets.get(bucket, 0) + 1
+        most = max(buckets.values())
+        for bucket in sorted(buckets):
+            out.write("  <=%6dus %6d %s\n" % (bucket, buckets[bucket],
+                                              "#" * max(1, buckets[bucket] * 40 // most)))
+
+f = open(args.log) if args.log else sys.stdin
+tasks, records = parse(f)
+if not records:
+    sys.stderr.write("no trace records found\n")
+    sys.exit(1)
+
+out = open(args.output, "w") if args.output else sys.stdout
+if args.chrome:
+    chrome(tasks, records, out)
+elif args.histogram:
+    histogram(tasks, records, out)
+else:
+    timeline(tasks, records, out)
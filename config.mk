@@ -34,6 +34,18 @@ CFLAGS_all += -O0 -ggdb -Wall -ffunction-sections -fdata-sections -mthumb -mlitt
 # CFLAGS_all += -Wno-implicit-function-declaration
 CFLAGS_all += -Wno-unused-variable -Wno-unused-function
 
+# System icons converted to native GBitmaps at build time. Set BITMAP_BENCH
+# (in localconfig.mk, or on the make command line) to keep each PNG too, as
+# <name>_PNG, so the bitmap load test can time both loaders
+RES_GBITMAP_all += RESOURCE_ID_CLOCK
+RES_GBITMAP_all += RESOURCE_ID_SPANNER
+RES_GBITMAP_all += RESOURCE_ID_SPEECH_BUBBLE
+RES_GBITMAP_all += RESOURCE_ID_MUSIC_PLAY
+RES_GBITMAP_all += RESOURCE_ID_MUSIC_PAUSE
+RES_GBITMAP_all += RESOURCE_ID_ALARM_BELL_RINGING
+MKPACKFLAGS_all += $(if $(BITMAP_BENCH),-k)
+CFLAGS_all += $(if $(BITMAP_BENCH),-DBITMAP_BENCH)
+
 LDFLAGS_all += -nostartfiles -nostdlib
 LIBS_all += -lgcc
 
@@ -55,6 +67,7 @@ SRCS_all += lib/minilib/fmt.c
 SRCS_all += lib/minilib/unfmt.c
 SRCS_all += lib/minilib/rand.c
 SRCS_all += lib/minilib/qalloc.c
+SRCS_all += lib/minilib/qslab.c
 SRCS_all += lib/musl/time/localtime.c
 SRCS_all += lib/musl/time/localtime_r.c
 SRCS_all += lib/musl/time/mktime.c
@@ -87,8 +100,10 @@ SRCS_all += rcore/appmanager_app_runloop.c
 SRCS_all += rcore/backlight.c
 SRCS_all += rcore/bluetooth.c
 SRCS_all += rcore/buttons.c
+SRCS_all += rcore/compositor.c
 SRCS_all += rcore/display.c
 SRCS_all += rcore/debug.c
+SRCS_all += rcore/deferred.c
 SRCS_all += rcore/gyro.c
 SRCS_all += rcore/main.c
 SRCS_all += rcore/notification_manager.c
@@ -106,6 +121,7 @@ SRCS_all += rcore/resource.c
 SRCS_all += rcore/watchdog.c
 SRCS_all += rcore/overlay_manager.c
 SRCS_all += rcore/rebble_util.c
+SRCS_all += rcore/trace.c
 
 SRCS_all += rcore/protocol/protocol_notification.c
 SRCS_all += rcore/protocol/protocol_system.c
@@ -125,6 +141,7 @@ SRCS_all += rwatch/ui/window.c
 SRCS_all += rwatch/ui/action_menu.c
 SRCS_all += rwatch/graphics/gbitmap.c
 SRCS_all += rwatch/graphics/graphics.c
+SRCS_all += rwatch/graphics/display_list.c
 SRCS_all += rwatch/graphics/font_loader.c
 SRCS_all += rwatch/event/tick_timer_service.c
 SRCS_all += rwatch/event/app_timer.c
@@ -58,6 +58,8 @@ defined in linker script */
 
 .word  _sccmidata
 .word  _eccmidata
+.word  _sccmbss
+.word  _eccmbss
 /* stack used for SystemInit_ExtMemCtl; always internal RAM used */
 
 /**
@@ -118,18 +120,17 @@ LoopFillZerobss:
   ldr  r3, = _ebss
   cmp  r2, r3
   bcc  FillZerobss
-/*   ldr  r2, = _sccmram */
-/*   b    LoopFillZeroCcm */
-/* Zero fill the CCM segment */
-/* FillZeroCcm: */
-/*   movs r3, #0 */
-/*   str  r3, [r2] */
-/*   adds r2, r2, #4 */
-
-/* LoopFillZeroCcm: */
-/*   ldr r3, = _eccmram */
-/*   cmp r2, r3 */
-/*   bcc FillZeroCcm */
+  ldr  r2, = _sccmbss
+  b    LoopFillZeroCcm
+/* Zero fill the CCM bss segment. */
+FillZeroCcm:
+  movs r3, #0
+  str  r3, [r2], #4
+
+LoopFillZeroCcm:
+  ldr  r3, = _eccmbss
+  cmp  r2, r3
+  bcc  FillZeroCcm
 
 /* Call the clock system intitialization function.*/
   bl  SystemInit
@@ -28,6 +28,7 @@
 #include "stm32_usart.h"
 #include "stm32_cc256x.h"
 #include "rebble_util.h"
+#include "trace.h"
 
 static stm32_bluetooth_config_t *_cc256x;
 
@@ -188,6 +189,7 @@ uint8_t stm32_cc256x_power_cycle(void)
  */
 void EXTI15_10_IRQHandler(void)
 {
+    TRACE_ISR_ENTER();
     if (EXTI_GetITStatus(EXTI_Line11) != RESET)
     {
         EXTI_ClearITPendingBit(EXTI_Line11);
@@ -199,6 +201,7 @@ void EXTI15_10_IRQHandler(void)
         /* Display used me */
         EXTI_ClearITPendingBit(EXTI_Line10);
     }
+    TRACE_ISR_EXIT();
 }
 
 
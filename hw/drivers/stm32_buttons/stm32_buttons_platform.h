@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include "stm32_buttons.h"
+#include "trace.h"
 
 typedef struct {
     uint16_t gpio_pin;
@@ -39,7 +40,9 @@ extern void stm32_buttons_raw_isr();
 #define STM32_BUTTONS_MK_IRQ_HANDLER(exti) \
     void EXTI ## exti ## _IRQHandler(void) \
     { \
+        TRACE_ISR_ENTER(); \
         stm32_buttons_raw_isr(); \
+        TRACE_ISR_EXIT(); \
     }
 
 #endif
@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include "trace.h"
+
 #define STM32_DMA_MK_FLAGS(CHAN) DMA_FLAG_FEIF##CHAN|DMA_FLAG_DMEIF##CHAN|DMA_FLAG_TEIF##CHAN|DMA_FLAG_HTIF##CHAN|DMA_FLAG_TCIF##CHAN
 
 
@@ -45,18 +47,22 @@ void stm32_dma_tx_isr(stm32_dma_t *dma);
 #define STM32_DMA_MK_TX_IRQ_HANDLER(dma_t, dma_channel, dma_stream, callback) \
     void DMA ## dma_channel ## _Stream ## dma_stream ## _IRQHandler(void) \
     { \
+        TRACE_ISR_ENTER(); \
         stm32_dma_tx_isr(dma_t); \
         callback  (); \
         stm32_power_release(STM32_POWER_AHB1, dma_t->dma_clock); \
+        TRACE_ISR_EXIT(); \
     }
 
 
 #define STM32_DMA_MK_RX_IRQ_HANDLER(dma_t, dma_channel, dma_stream, callback) \
     void DMA ## dma_channel ## _Stream ## dma_stream ## _IRQHandler(void) \
     { \
+        TRACE_ISR_ENTER(); \
         stm32_dma_rx_isr(dma_t); \
         callback  (); \
         stm32_power_release(STM32_POWER_AHB1, dma_t->dma_clock); \
+        TRACE_ISR_EXIT(); \
     }
 
 
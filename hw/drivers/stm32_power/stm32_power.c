@@ -129,3 +129,29 @@ void stm32_power_incr(stm32_power_register_t reg, uint32_t domain, int incr) {
     taskEXIT_CRITICAL_FROM_ISR(critical_state);
 #endif
 }
+
+/* STOP mode halts every bus clock. The GPIOs hold their state through
+ * it, and PWR and SYSCFG are only held for configuration, so those
+ * don't stop us; anything else clocked is mid transfer (DMA, SPI, UART)
+ * or needs to keep running (timers driving PWM) */
+#define STOP_SAFE_AHB1 ~(RCC_AHB1Periph_DMA1 | RCC_AHB1Periph_DMA2)
+#define STOP_SAFE_APB1 RCC_APB1Periph_PWR
+#define STOP_SAFE_APB2 RCC_APB2Periph_SYSCFG
+
+static int _stop_safe(uint8_t *statep, int bits, uint32_t safe) {
+    for (int i = 0; i < bits; i++)
+        if (statep[i] && !(safe & (1UL << i)))
+            return 0;
+    return 1;
+}
+
+/* Can we go into STOP mode without upsetting a peripheral? Called from
+ * the idle task with interrupts off, so nobody can request a clock
+ * behind our back */
+int stm32_power_stop_safe(void) {
+    return _stop_safe(_power_state_AHB1, sizeof(_power_state_AHB1), STOP_SAFE_AHB1) &&
+           _stop_safe(_power_state_AHB2, sizeof(_power_state_AHB2), 0) &&
+           _stop_safe(_power_state_AHB3, sizeof(_power_state_AHB3), 0) &&
+           _stop_safe(_power_state_APB1, sizeof(_power_state_APB1), STOP_SAFE_APB1) &&
+           _stop_safe(_power_state_APB2, sizeof(_power_state_APB2), STOP_SAFE_APB2);
+}
@@ -24,9 +24,13 @@
 #include "stm32_power.h"
 #include "stm32_rtc.h"
 #include "log.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <time.h>
 
+/* The wakeup timer runs from the 32.768kHz RTC clock divided by 16 */
+#define RTC_WAKEUP_HZ (32768 / 16)
+
 // a buffer for the last captured time to avoid malloc
 static struct tm time_now;
 
@@ -60,9 +64,10 @@ void rtc_init(void)
     NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
     NVIC_Init(&NVIC_InitStruct);
 
-    // Configure the RTC WakeUp Clock source: CK_SPRE (1Hz)
-    RTC_WakeUpClockConfig(RTC_WakeUpClock_CK_SPRE_16bits);
-    RTC_SetWakeUpCounter(0x0);
+    // The wakeup timer is armed by rtc_wakeup_arm when we go to sleep,
+    // at ~0.5ms resolution for up to 32s
+    RTC_WakeUpCmd(DISABLE);
+    RTC_WakeUpClockConfig(RTC_WakeUpClock_RTCCLK_Div16);
 
     // Enable the RTC Wakeup Interrupt
     RTC_ITConfig(RTC_IT_WUT, ENABLE);
@@ -70,11 +75,54 @@ void rtc_init(void)
     RTC_ClearITPendingBit(RTC_IT_WUT);
     EXTI_ClearITPendingBit(EXTI_Line22);
 
-    // Enable Wakeup Counter
+    stm32_power_release(STM32_POWER_APB2, RCC_APB2Periph_SYSCFG);
+}
+
+/*
+ * Fire the wakeup interrupt once, ms from now. Anything past the 16 bit
+ * counter's 32s is clamped
+ */
+void rtc_wakeup_arm(uint32_t ms)
+{
+    uint32_t count = ms * RTC_WAKEUP_HZ / 1000;
+
+    if (count == 0)
+        count = 1;
+    if (count > 0x10000)
+        count = 0x10000;
+
+    RTC_WakeUpCmd(DISABLE);
+    RTC_SetWakeUpCounter(count - 1);
+    RTC_ClearITPendingBit(RTC_IT_WUT);
+    EXTI_ClearITPendingBit(EXTI_Line22);
     RTC_WakeUpCmd(ENABLE);
+}
 
-    stm32_power_release(STM32_POWER_APB2, RCC_APB2Periph_SYSCFG);
+void rtc_wakeup_disarm(void)
+{
+    RTC_WakeUpCmd(DISABLE);
 }
+
+#if defined(STM32F4XX)
+/*
+ * Time of day in 1/RTC_SUBSECOND_HZ seconds, for measuring how long we
+ * slept. Reading SSR first latches the time until the date is read
+ */
+uint32_t rtc_get_subseconds_of_day(void)
+{
+    uint32_t ss = RTC_GetSubSecond();
+    uint32_t tr = RTC->TR;
+    (void)RTC->DR;
+
+    uint32_t hours = ((tr >> 20) & 0x3) * 10 + ((tr >> 16) & 0xF);
+    uint32_t minutes = ((tr >> 12) & 0x7) * 10 + ((tr >> 8) & 0xF);
+    uint32_t seconds = ((tr >> 4) & 0x7) * 10 + (tr & 0xF);
+
+    /* SSR counts down from the prescaler */
+    return ((hours * 60 + minutes) * 60 + seconds) * RTC_SUBSECOND_HZ +
+           (RTC_SUBSECOND_HZ - 1 - ss);
+}
+#endif
 void rtc_config(void)
 {
     RTC_InitTypeDef  RTC_InitStructure;
@@ -182,10 +230,12 @@ void hw_set_date_time(struct tm date_time)
 
 void RTC_WKUP_IRQHandler(void)
 {
+    TRACE_ISR_ENTER();
     if(RTC_GetITStatus(RTC_IT_WUT) != RESET)
     {
         RTC_ClearITPendingBit(RTC_IT_WUT);
 //         DRV_LOG("RTC", APP_LOG_LEVEL_DEBUG, "RTC WAKE IRQ");
         EXTI_ClearITPendingBit(EXTI_Line22);
     }
+    TRACE_ISR_EXIT();
 }
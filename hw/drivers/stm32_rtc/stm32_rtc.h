@@ -24,6 +24,15 @@ void rtc_init(void);
 void rtc_config(void);
 struct tm *hw_get_time(void);
 
+/* The synchronous prescaler counts subseconds at this rate */
+#define RTC_SUBSECOND_HZ 256
+
+void rtc_wakeup_arm(uint32_t ms);
+void rtc_wakeup_disarm(void);
+#if defined(STM32F4XX)
+uint32_t rtc_get_subseconds_of_day(void);
+#endif
+
 #endif
 
 #define RTC_CLOCK_SOURCE_LSE
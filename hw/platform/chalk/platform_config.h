@@ -11,6 +11,9 @@
 #define DISPLAY_ROWS 180
 #define DISPLAY_COLS 180
 
+/* The round framebuffer fills CCRAM, so the system task stacks stay in SRAM */
+#define CCRAM_SYSTEM_STACK
+
 extern unsigned char _binary_Resources_chalk_fpga_bin_size;
 extern unsigned char _binary_Resources_chalk_fpga_bin_start;
 #define DISPLAY_FPGA_ADDR &_binary_Resources_chalk_fpga_bin_start
@@ -14,6 +14,12 @@
 //We are a square device
 #define PBL_RECT
 
+/* Stacks of the small, DMA-free system tasks (buttons, backlight, idle),
+ * about 4.7KB. Next to the framebuffer, the worker, overlay and
+ * notification heaps and the panic stack that leaves about 2.1KB of
+ * CCRAM, so larger stacks (watchdog, deferred) stay in SRAM */
+#define CCRAM_SYSTEM_STACK CCRAM_BSS
+
 extern unsigned char _binary_Resources_snowy_fpga_bin_size;
 extern unsigned char _binary_Resources_snowy_fpga_bin_start;
 #define DISPLAY_FPGA_ADDR &_binary_Resources_snowy_fpga_bin_start
@@ -3,4 +3,7 @@
 
 #include "system_stm32f4xx.h"
 
+/* Sleep through idle periods on the RTC wakeup timer; see power.c */
+#define configUSE_TICKLESS_IDLE 2
+
 #endif
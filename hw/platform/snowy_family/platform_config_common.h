@@ -20,6 +20,12 @@
 #define MEMORY_SIZE_WORKER_HEAP   MEMORY_SIZE_WORKER - (MEMORY_SIZE_WORKER_STACK * 4)
 #define MEMORY_SIZE_OVERLAY_HEAP  MEMORY_SIZE_OVERLAY - (MEMORY_SIZE_OVERLAY_STACK * 4)
 
+/* Scratch space for app_frame_alloc, taken from a thread's heap on first use */
+#define MEMORY_SIZE_FRAME_ARENA   2560
+
+/* Relocated app images kept on the system heap, for quick relaunch */
+#define APP_IMAGE_CACHE_SIZE      8192
+
 // flash regions
 #define REGION_PRF_START        0x200000
 #define REGION_PRF_SIZE         0x1000000
@@ -59,6 +65,9 @@
  * into memory bank 2. Note bank 2 is NOT DMA capable
  */
 #define CCRAM __attribute__((section(".ccmram")))
+/* As CCRAM, for objects with no initial value (heaps, stacks). These are
+ * zeroed at boot rather than copied out of flash */
+#define CCRAM_BSS __attribute__((section(".ccmbss")))
 
 //Snowy uses OC1 for backlight
 #define BL_TIM_CH 1
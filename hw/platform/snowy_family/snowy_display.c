@@ -21,10 +21,16 @@
 #include "platform_config.h"
 #include "rebble_memory.h"
 #include "resource.h"
+#include "deferred.h"
 
 #define ROW_LENGTH    DISPLAY_COLS
 #define COLUMN_LENGTH DISPLAY_ROWS
-static uint8_t _column_buffer[COLUMN_LENGTH];
+/* Columns are converted into one buffer while the other is sent.
+ * Column n always lives in buffer n & 1 */
+static uint8_t _column_buffer[2][COLUMN_LENGTH];
+/* The last column converted, and the one the DMA is waiting on, if any */
+static volatile int16_t _column_converted;
+static volatile int16_t _column_waiting;
 static uint8_t _display_ready;
 
 void _snowy_display_start_frame(uint8_t xoffset, uint8_t yoffset);
@@ -47,6 +53,7 @@ void _snowy_display_dma_send(uint8_t *data, uint32_t len);
 void _snowy_display_next_column(uint8_t col_index);
 void _snowy_display_init_dma(void);
 static void _spi_tx_done(void);
+static void _snowy_display_convert_column(void *arg, uint32_t col_index);
 
 // pointer to the place in flash where the FPGA image resides
 // extern unsigned char fpga_address; // _binary_Resources_FPGA_4_3_snowy_dumped_bin_start;
@@ -274,8 +281,24 @@ static void _spi_tx_done(void)
     if (col_index < ROW_LENGTH - 1)
     {
         ++col_index;
-        // ask for convert and display the next column
-        _snowy_display_next_column(col_index);
+        /* send the next column if it's ready, and have the one after
+         * converted into the buffer we just finished with. Converting
+         * is the slow part, so it stays out of the interrupt */
+        if (_column_converted == col_index)
+        {
+            _snowy_display_dma_send(_column_buffer[col_index & 1], COLUMN_LENGTH);
+            if (col_index < ROW_LENGTH - 1 &&
+                !deferred_call_from_isr(_snowy_display_convert_column, NULL, col_index + 1))
+            {
+                /* no room to hand it off; better slow than a stuck frame */
+                scanline_convert(_column_buffer[(col_index + 1) & 1], display.frame_buffer, col_index + 1);
+                _column_converted = col_index + 1;
+            }
+        }
+        else
+        {
+            _column_waiting = col_index;
+        }
         return;
     }
     // done. We are still in control of the SPI select, so lets let go
@@ -350,12 +373,47 @@ uint8_t _snowy_display_SPI6_send(uint8_t data)
 
 /*
  * Given a column index, start the conversion of the display data and dma it
+ * Only for the first column of a frame; the rest are converted on the
+ * deferred worker while the one before is sent
  */
 void _snowy_display_next_column(uint8_t col_index)
 {   
     // set the content
-    scanline_convert(_column_buffer, display.frame_buffer, col_index);
-    _snowy_display_dma_send(_column_buffer, COLUMN_LENGTH);
+    scanline_convert(_column_buffer[col_index & 1], display.frame_buffer, col_index);
+    _column_converted = col_index;
+    _column_waiting = -1;
+    _snowy_display_dma_send(_column_buffer[col_index & 1], COLUMN_LENGTH);
+    
+    if (col_index < ROW_LENGTH - 1)
+        _snowy_display_convert_column(NULL, col_index + 1);
+}
+
+/*
+ * Convert a column ahead of it being sent. If the DMA got there first
+ * and is waiting on it, start it off again from here and carry on with
+ * the next one, as nobody else will
+ */
+static void _snowy_display_convert_column(void *arg, uint32_t col_index)
+{
+    for (;;)
+    {
+        scanline_convert(_column_buffer[col_index & 1], display.frame_buffer, col_index);
+        
+        /* the DMA interrupt looks at these too */
+        taskENTER_CRITICAL();
+        _column_converted = col_index;
+        uint8_t resume = _column_waiting == col_index;
+        if (resume)
+        {
+            _column_waiting = -1;
+            _snowy_display_dma_send(_column_buffer[col_index & 1], COLUMN_LENGTH);
+        }
+        taskEXIT_CRITICAL();
+        
+        if (!resume || col_index == ROW_LENGTH - 1)
+            return;
+        col_index++;
+    }
 }
 
 /*
@@ -514,9 +572,9 @@ void _snowy_display_send_frame_slow()
     // send via standard SPI
     for(uint8_t x = 0; x < DISPLAY_COLS; x++)
     {
-        scanline_convert(_column_buffer, display.frame_buffer, x);
+        scanline_convert(_column_buffer[0], display.frame_buffer, x);
         for (uint8_t j = 0; j < DISPLAY_ROWS; j++)
-            _snowy_display_SPI6_send(_column_buffer[j]);
+            _snowy_display_SPI6_send(_column_buffer[0][j]);
     }   
     
     _snowy_display_cs(0);
@@ -14,6 +14,7 @@
 #include <stm32f4xx_tim.h>
 #include "stm32f4x_i2c.h"
 #include "stm32_power.h"
+#include "stm32_rtc.h"
 
 // useful?
 // https://developer.mbed.org/users/switches/code/MAX14690/file/666b6c505289/MAX14690.h
@@ -54,6 +55,56 @@ void hw_power_init(void)
     max14690_init();
 }
 
+/* STOP leaves us running from the HSI. Bring the PLL back up and switch
+ * to it again, the rest of the clock tree is as SystemInit left it */
+static void _restore_sysclk(void)
+{
+    RCC->CR |= RCC_CR_PLLON;
+    while ((RCC->CR & RCC_CR_PLLRDY) == 0)
+        ;
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+        ;
+}
+
+/*
+ * Sleep the core for up to max_ms, with the RTC wakeup timer set to bring
+ * us back. If no peripheral needs its clock we go all the way down to
+ * STOP, else just WFI.
+ * Called with interrupts disabled and the SysTick stopped; an interrupt
+ * going pending wakes us early, and is taken once the caller enables them
+ * again. The caller times the sleep from the RTC.
+ * Returns whether we were in STOP
+ */
+uint8_t hw_power_sleep(uint32_t max_ms)
+{
+    uint8_t stopped;
+
+    rtc_wakeup_arm(max_ms);
+
+    stopped = stm32_power_stop_safe();
+    if (stopped)
+    {
+        stm32_power_request(STM32_POWER_APB1, RCC_APB1Periph_PWR);
+        PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI);
+        _restore_sysclk();
+        stm32_power_release(STM32_POWER_APB1, RCC_APB1Periph_PWR);
+        /* the calendar shadow registers stood still while we were stopped */
+        RTC_WaitForSynchro();
+    }
+    else
+    {
+        __DSB();
+        __WFI();
+        __ISB();
+    }
+
+    rtc_wakeup_disarm();
+
+    return stopped;
+}
+
 void max14690_init(void)
 {
     /*
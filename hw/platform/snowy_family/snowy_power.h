@@ -26,4 +26,5 @@ typedef struct {
 } max14690_t;
 
 void hw_power_init(void);
+uint8_t hw_power_sleep(uint32_t max_ms);
 void max14690_init(void);
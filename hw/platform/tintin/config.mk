@@ -28,6 +28,9 @@ SRCS_tintin += hw/platform/tintin/tintin_asm.s
 LDFLAGS_tintin = $(LDFLAGS_stm32f2xx)
 LIBS_tintin = $(LIBS_stm32f2xx)
 
+# The display is black and white, so native bitmaps are converted to match
+MKPACKFLAGS_tintin = -b
+
 QEMUFLAGS_tintin = -machine pebble-bb2 -cpu cortex-m3
 QEMUSPITYPE_tintin = mtdblock
 QEMUPACKSIZE_tintin = 512000
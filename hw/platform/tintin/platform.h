@@ -59,5 +59,7 @@
 #define RES_START           0x200C
 
 #define CCRAM
+#define CCRAM_BSS
+#define CCRAM_SYSTEM_STACK
 
 #endif
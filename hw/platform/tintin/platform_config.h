@@ -23,6 +23,9 @@
 #define MEMORY_SIZE_APP_HEAP      MEMORY_SIZE_APP - (MEMORY_SIZE_APP_STACK * 4)
 #define MEMORY_SIZE_WORKER_HEAP   MEMORY_SIZE_WORKER - (MEMORY_SIZE_WORKER_STACK * 4)
 #define MEMORY_SIZE_OVERLAY_HEAP  MEMORY_SIZE_OVERLAY - (MEMORY_SIZE_OVERLAY_STACK * 4)
+
+/* Scratch space for app_frame_alloc, taken from a thread's heap on first use */
+#define MEMORY_SIZE_FRAME_ARENA   1024
 //Tintin uses OC2 for backlight
 #define BL_TIM_CH 2
 
@@ -8,13 +8,56 @@
 #ifndef QALLOC_H
 #define QALLOC_H
 
+/* Free blocks are kept on segregated lists, one per power-of-two size
+ * class. Bin i holds blocks of size [16 << i, 32 << i). */
+#define QALLOC_NBINS 12
+
+/* Number of movable blocks an arena can have at once.  The handle table
+ * is taken from the arena the first time qhalloc is called on it. */
+#define QALLOC_NHANDLES 16
+
+struct qfreeblock;
+
+/* A movable block is reached through its master pointer, which qcompact
+ * updates when it moves the block.  Only dereference ->ptr between
+ * qhlock and qhunlock; locked blocks are never moved. */
+typedef struct qmaster {
+	void *ptr;
+	unsigned int locks;
+} *qhandle_t;
+
 typedef struct _qarena_t {
 	unsigned int size;
-	/* ... */
+	unsigned int binmap;	/* bit i set if bins[i] is non-empty */
+	struct qfreeblock *bins[QALLOC_NBINS];
+	/* running totals, so stats don't need a heap walk */
+	unsigned int used;
+	unsigned int peak;
+	unsigned int nfree;
+	unsigned int nfail;
+	struct qmaster *handles;	/* QALLOC_NHANDLES of them, or NULL */
 } qarena_t;
 
+/* A snapshot of an arena.  Byte counts include block headers. */
+typedef struct _qstats_t {
+	unsigned int size;		/* bytes managed by the arena */
+	unsigned int used;		/* bytes in allocated blocks */
+	unsigned int peak;		/* most bytes ever in allocated blocks */
+	unsigned int largest_free;	/* biggest request that can currently succeed */
+	unsigned int free_blocks;
+	unsigned int alloc_fails;
+} qstats_t;
+
 extern qarena_t *qinit(void *start, unsigned size);
 extern void *qalloc(qarena_t *arena, unsigned size);
 extern void qfree(qarena_t *arena, void *ptr);
+extern void qstats(qarena_t *arena, qstats_t *stats);
+
+extern qhandle_t qhalloc(qarena_t *arena, unsigned size);
+extern void qhfree(qarena_t *arena, qhandle_t h);
+extern unsigned qhavail(qarena_t *arena);
+extern void *qhlock(qhandle_t h);
+extern void qhunlock(qhandle_t h);
+extern unsigned qcompact(qarena_t *arena);
 
 #endif /* !QALLOC_H */
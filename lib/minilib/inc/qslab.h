@@ -0,0 +1,27 @@
+/* qslab.h
+ * Fixed-size object slabs on top of a qalloc arena
+ *
+ * Public domain; optionally see LICENSE
+ */
+
+#ifndef QSLAB_H
+#define QSLAB_H
+
+#include <qalloc.h>
+
+struct qslabpage;
+
+typedef struct _qslab_t {
+	qarena_t *arena;
+	unsigned short stride;		/* object size plus its page pointer */
+	unsigned short perpage;
+	struct qslabpage *partial;	/* pages with at least one free object */
+	unsigned int pages;
+	unsigned int inuse;
+} qslab_t;
+
+extern void qslab_init(qslab_t *slab, qarena_t *arena, unsigned objsz, unsigned perpage);
+extern void *qslab_alloc(qslab_t *slab);
+extern void qslab_free(qslab_t *slab, void *ptr);
+
+#endif /* !QSLAB_H */
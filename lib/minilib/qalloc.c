@@ -13,10 +13,19 @@
 #define HEAP_INTEGRITY
 //#define HEAP_PARANOID
 
-#define MINBSZ	4
+/*
+ * Every block starts with a qblock_t header.  Free blocks also carry a
+ * boundary tag -- a copy of their size -- in their last word, and the
+ * block after a free block has SZFLAG_FPREVFREE set, so free() can find
+ * and merge with both physical neighbours without walking the heap.
+ *
+ * Free blocks are threaded onto a doubly linked list per size class
+ * (see QALLOC_NBINS), so allocation only looks at blocks that might fit.
+ */
 
 #define SZFLAG_SZ (~3)
 #define SZFLAG_FFREE 1
+#define SZFLAG_FPREVFREE 2
 
 
 typedef struct qblock {
@@ -29,121 +38,405 @@ typedef struct qblock {
 #endif
 } qblock_t;
 
+/* Free list links live in the payload of a free block */
+typedef struct qfreeblock {
+	qblock_t hdr;
+	struct qfreeblock *next;
+	struct qfreeblock *prev;
+} qfreeblock_t;
+
+/* header, links, and the boundary tag */
+#define MINBSZ	(sizeof(qfreeblock_t) + sizeof(unsigned long))
+
 #define ALIGN(s)	((s + 3) & ~3)
 
 #define BLK(blk)        ((qblock_t *)(blk))
+#define FBLK(blk)       ((qfreeblock_t *)(blk))
 #define BLK_FROMPAYLOAD(p)	(void*)((char*)(p) - sizeof(qblock_t))
 #define BLK_SZ(blk)	((blk)->szflag & SZFLAG_SZ)
 #define BLK_NEXT(blk)	((qblock_t *)((char*)(blk) + BLK_SZ(blk)))
 #define BLK_ISFREE(blk)	((blk)->szflag & SZFLAG_FFREE)
 #define BLK_FREE(blk)	((blk)->szflag |= SZFLAG_FFREE)
 #define BLK_ALLOC(blk)	((blk)->szflag &= ~SZFLAG_FFREE)
+#define BLK_ISPREVFREE(blk)	((blk)->szflag & SZFLAG_FPREVFREE)
 #define BLK_PAYLOAD(p)	(void*)((char*)(p) + sizeof(qblock_t))
+#define BLK_FOOTER(blk)	(((unsigned long *)BLK_NEXT(blk))[-1])
+#define BLK_PREV(blk)	((qblock_t *)((char*)(blk) - ((unsigned long *)(blk))[-1]))
 #define BLK_COOKIE(arena, blk) ((unsigned)(arena) >> 4 ^ (unsigned)(blk))
+#define ARENA_END(arena)	BLK((char *)(arena) + (arena)->size)
 
-static void qjoin(qarena_t *arena);
 static void qcheck(qarena_t *arena, qblock_t *blk);
+static unsigned qbin(unsigned size);
+static void qlink(qarena_t *arena, qblock_t *blk);
+static void qunlink(qarena_t *arena, qblock_t *blk);
+static void qmkfree(qarena_t *arena, qblock_t *blk, unsigned size);
+static struct qmaster *qhowner(qarena_t *arena, qblock_t *blk);
 
 qarena_t *qinit(void *start, unsigned size) {
 	qarena_t *arena = start;
-	arena->size = size;
-	
+	arena->size = (size - sizeof(*arena)) & ~3;
+	arena->size += sizeof(*arena);
+	arena->binmap = 0;
+	memset(arena->bins, 0, sizeof(arena->bins));
+	arena->used = arena->peak = 0;
+	arena->nfree = arena->nfail = 0;
+	arena->handles = NULL;
+
 	qblock_t *blk = BLK(arena + 1); // start = &arena[1], so arena[0] is left alone.
-	blk->szflag = size - sizeof(*arena);
-#ifdef HEAP_INTEGRITY
-	blk->cookie0 = BLK_COOKIE(arena, blk);
-	blk->cookie1 = ~BLK_COOKIE(arena, blk);
-#endif
-#ifdef HEAP_PARANOID
-	memset(BLK_PAYLOAD(blk), 0xAA, BLK_SZ(blk) - sizeof(qblock_t));
-#endif
-	BLK_FREE(blk);
-	
+	blk->szflag = 0;
+	qmkfree(arena, blk, arena->size - sizeof(*arena));
+
 	return arena;
 }
 
 void *qalloc(qarena_t *arena, unsigned size) {
-	qblock_t *blk = BLK(arena+1);
-	qblock_t *end = BLK((char *)arena + arena->size);
-	void *n = NULL;
-	
+	qblock_t *end = ARENA_END(arena);
+	qfreeblock_t *fblk;
+	qblock_t *blk = NULL;
+	unsigned bin;
+
 	if (size == 0)
 		return NULL;
 
 	size = ALIGN(size) + sizeof(qblock_t);
-	
-	while (blk && blk < end) {
-		qcheck(arena, blk);
-		
-		/* We need either exactly enough room for this block, or we
-		 * need enough room for this and one more block to be
-		 * constructed at the end.  */
-		if (!BLK_ISFREE(blk) ||
-		    ((BLK_SZ(blk) != size) &&
-		     (BLK_SZ(blk) < size + sizeof(qblock_t)))) {
-			blk = BLK_NEXT(blk);
-			continue;
+	if (size < MINBSZ)
+		size = MINBSZ;
+
+	/* Blocks in our own bin may be too small, so first-fit through it.
+	 * Anything in a larger bin is big enough, so just take the head. */
+	bin = qbin(size);
+	for (fblk = arena->bins[bin]; fblk; fblk = fblk->next) {
+		qcheck(arena, BLK(fblk));
+		if (BLK_SZ(BLK(fblk)) >= size) {
+			blk = BLK(fblk);
+			break;
 		}
+	}
 
-		if (BLK_SZ(blk) > size) {
-			qblock_t *nblk = BLK((char*)blk + size);
-			nblk->szflag = BLK_SZ(blk) - size;
-			blk->szflag = size;
-#ifdef HEAP_INTEGRITY
-			nblk->cookie0 = BLK_COOKIE(arena, nblk);
-			nblk->cookie1 = ~BLK_COOKIE(arena, nblk);
-#endif
-			BLK_FREE(nblk);
+	if (!blk) {
+		unsigned larger = bin + 1 < QALLOC_NBINS ? arena->binmap & ~((2u << bin) - 1) : 0;
+		if (!larger) {
+			arena->nfail++;
+			return NULL;
 		}
+		blk = BLK(arena->bins[__builtin_ctz(larger)]);
+		qcheck(arena, blk);
+	}
+
+	qunlink(arena, blk);
+
+	/* Split if what's left over is big enough to be a block of its own */
+	if (BLK_SZ(blk) - size >= MINBSZ) {
+		qblock_t *nblk = BLK((char*)blk + size);
+		nblk->szflag = 0;
+		qmkfree(arena, nblk, BLK_SZ(blk) - size);
+		blk->szflag = size | (blk->szflag & ~SZFLAG_SZ);
+	} else {
+		qblock_t *nblk = BLK_NEXT(blk);
+		if (nblk < end)
+			nblk->szflag &= ~SZFLAG_FPREVFREE;
+	}
 
 #ifdef HEAP_INTEGRITY
-		blk->cookie0 = ~BLK_COOKIE(arena, blk);
-		blk->cookie1 = BLK_COOKIE(arena, blk);
+	blk->cookie0 = ~BLK_COOKIE(arena, blk);
+	blk->cookie1 = BLK_COOKIE(arena, blk);
 #endif
-		BLK_ALLOC(blk);
-		
-		return BLK_PAYLOAD(blk);
-	}
-	return NULL;
+	BLK_ALLOC(blk);
+
+	arena->used += BLK_SZ(blk);
+	if (arena->used > arena->peak)
+		arena->peak = arena->used;
+
+	return BLK_PAYLOAD(blk);
 }
 
 void qfree(qarena_t *arena, void *ptr) {
 	if (!ptr)
 		return;
-		
+
+	qblock_t *end = ARENA_END(arena);
 	qblock_t *blk = BLK_FROMPAYLOAD(ptr);
+	qblock_t *nblk;
+	unsigned size;
 
 #ifdef HEAP_INTEGRITY
 	qcheck(arena, blk);
 	if (BLK_ISFREE(blk))
 		panic("qfree: double free");	/* XXX: this "panic" needs to not panic if we are in an app */
 #endif
+
+	size = BLK_SZ(blk);
+	arena->used -= size;
+
+	/* merge with the block after us */
+	nblk = BLK_NEXT(blk);
+	if (nblk < end && BLK_ISFREE(nblk)) {
+		qcheck(arena, nblk);
+		qunlink(arena, nblk);
+		size += BLK_SZ(nblk);
 #ifdef HEAP_PARANOID
-	memset(BLK_PAYLOAD(blk), 0xAA, BLK_SZ(blk) - sizeof(qblock_t));
+		memset(nblk, 0xAA, sizeof(qfreeblock_t));
 #endif
+	}
 
-	BLK_FREE(blk);
-	blk->cookie0 = BLK_COOKIE(arena, blk);
-	blk->cookie1 = ~BLK_COOKIE(arena, blk);
-	qjoin(arena);
+	/* and the one before, found through its boundary tag */
+	if (BLK_ISPREVFREE(blk)) {
+		qblock_t *pblk = BLK_PREV(blk);
+		qcheck(arena, pblk);
+		if (!BLK_ISFREE(pblk) || BLK_NEXT(pblk) != blk)
+			panic("qfree: boundary tag corrupt");
+		qunlink(arena, pblk);
+		size += BLK_SZ(pblk);
+#ifdef HEAP_PARANOID
+		memset(blk, 0xAA, sizeof(qfreeblock_t));
+#endif
+		blk = pblk;
+	}
+
+	qmkfree(arena, blk, size);
+}
+
+/*
+ * Snapshot the arena.  Only the largest non-empty size class is searched
+ * for the biggest free block; everything else is a running total.
+ */
+void qstats(qarena_t *arena, qstats_t *stats) {
+	qfreeblock_t *fblk;
+	unsigned largest = 0;
+
+	stats->size = arena->size;
+	stats->used = arena->used;
+	stats->peak = arena->peak;
+	stats->free_blocks = arena->nfree;
+	stats->alloc_fails = arena->nfail;
+
+	if (arena->binmap) {
+		unsigned bin = 31 - __builtin_clz(arena->binmap);
+		for (fblk = arena->bins[bin]; fblk; fblk = fblk->next)
+			if (BLK_SZ(BLK(fblk)) > largest)
+				largest = BLK_SZ(BLK(fblk));
+	}
+	stats->largest_free = largest ? largest - sizeof(qblock_t) : 0;
+}
+
+/*
+ * Movable blocks.  The payload of a handle's block starts with a pointer
+ * back to its master, so qcompact can tell which blocks it may move and
+ * whose pointer to fix up.  The master has to point back at the block
+ * too, so ordinary data that happens to look like a master pointer
+ * can't fool it.
+ */
+
+qhandle_t qhalloc(qarena_t *arena, unsigned size) {
+	struct qmaster *m;
+	struct qmaster **blk;
+	unsigned i;
+
+	if (!arena->handles) {
+		arena->handles = qalloc(arena, QALLOC_NHANDLES * sizeof(struct qmaster));
+		if (!arena->handles)
+			return NULL;
+		memset(arena->handles, 0, QALLOC_NHANDLES * sizeof(struct qmaster));
+	}
+
+	for (i = 0, m = NULL; i < QALLOC_NHANDLES; i++)
+		if (!arena->handles[i].ptr) {
+			m = &arena->handles[i];
+			break;
+		}
+	if (!m)
+		return NULL;
+
+	blk = qalloc(arena, size + sizeof(struct qmaster *));
+	if (!blk) {
+		/* the space may be there, just not in one piece */
+		qcompact(arena);
+		blk = qalloc(arena, size + sizeof(struct qmaster *));
+		if (!blk)
+			return NULL;
+	}
+
+	*blk = m;
+	m->ptr = blk + 1;
+	m->locks = 0;
+
+	return m;
 }
 
-static void qjoin(qarena_t *arena) {
-	qblock_t *blk = BLK(arena+1);
-	qblock_t *end = (qblock_t *)((char *)arena + arena->size);
-	
-	while (blk && blk < end) {
+/*
+ * How many more handles the arena can hand out.
+ */
+unsigned qhavail(qarena_t *arena) {
+	unsigned i, n;
+
+	if (!arena->handles)
+		return QALLOC_NHANDLES;
+
+	for (i = 0, n = 0; i < QALLOC_NHANDLES; i++)
+		if (!arena->handles[i].ptr)
+			n++;
+
+	return n;
+}
+
+void qhfree(qarena_t *arena, qhandle_t h) {
+	if (!h)
+		return;
+
+	qfree(arena, (struct qmaster **)h->ptr - 1);
+	h->ptr = NULL;
+	h->locks = 0;
+}
+
+void *qhlock(qhandle_t h) {
+	h->locks++;
+	return h->ptr;
+}
+
+void qhunlock(qhandle_t h) {
+	if (h->locks)
+		h->locks--;
+}
+
+/*
+ * Slide unlocked movable blocks down over the free space in front of
+ * them, so the free space gathers into larger blocks behind them.
+ * Anything else stays put and free space in front of it stays there.
+ * Returns the largest request that can now succeed.
+ */
+unsigned qcompact(qarena_t *arena) {
+	qblock_t *end = ARENA_END(arena);
+	qblock_t *blk = BLK(arena + 1);
+	qstats_t stats;
+
+	while (blk < end) {
+		qblock_t *mblk, *nblk;
+		struct qmaster *m;
+		unsigned fsize, msize;
+
 		qcheck(arena, blk);
-		if (BLK_NEXT(blk) < end && BLK_ISFREE(blk) && BLK_ISFREE(BLK_NEXT(blk))) {
-			qblock_t *nblk = BLK_NEXT(blk);
-			blk->szflag += BLK_SZ(nblk);
-#ifdef HEAP_PARANOID
-			memset(nblk, 0xAA, sizeof(qblock_t));
-#endif
-		} else {
+		if (!BLK_ISFREE(blk)) {
 			blk = BLK_NEXT(blk);
+			continue;
+		}
+
+		mblk = BLK_NEXT(blk);
+		if (mblk >= end)
+			break;
+		m = qhowner(arena, mblk);
+		if (!m || m->locks) {
+			blk = BLK_NEXT(mblk);
+			continue;
+		}
+
+		/* free block blk, then movable mblk: swap them round */
+		fsize = BLK_SZ(blk);
+		msize = BLK_SZ(mblk);
+		qunlink(arena, blk);
+		memmove(blk, mblk, msize);
+		/* the block before a free block is never free */
+		blk->szflag = msize;
+#ifdef HEAP_INTEGRITY
+		blk->cookie0 = ~BLK_COOKIE(arena, blk);
+		blk->cookie1 = BLK_COOKIE(arena, blk);
+#endif
+		m->ptr = (struct qmaster **)BLK_PAYLOAD(blk) + 1;
+
+		/* and the free space moves up, merging with what follows */
+		mblk = BLK_NEXT(blk);
+		nblk = BLK((char *)mblk + fsize);
+		if (nblk < end && BLK_ISFREE(nblk)) {
+			qcheck(arena, nblk);
+			qunlink(arena, nblk);
+			fsize += BLK_SZ(nblk);
 		}
+		mblk->szflag = 0;
+		qmkfree(arena, mblk, fsize);
+
+		blk = mblk;
 	}
+
+	qstats(arena, &stats);
+	return stats.largest_free;
+}
+
+/* Private functions */
+
+/*
+ * Turn blk into a free block of size bytes, tag it, tell the next block,
+ * and put it on its free list.  The caller has already merged neighbours.
+ */
+static void qmkfree(qarena_t *arena, qblock_t *blk, unsigned size) {
+	qblock_t *end = ARENA_END(arena);
+
+	blk->szflag = size | (blk->szflag & SZFLAG_FPREVFREE);
+	BLK_FREE(blk);
+#ifdef HEAP_INTEGRITY
+	blk->cookie0 = BLK_COOKIE(arena, blk);
+	blk->cookie1 = ~BLK_COOKIE(arena, blk);
+#endif
+	BLK_FOOTER(blk) = size;
+#ifdef HEAP_PARANOID
+	memset((char *)blk + sizeof(qfreeblock_t), 0xAA, size - MINBSZ);
+#endif
+
+	qblock_t *nblk = BLK_NEXT(blk);
+	if (nblk < end)
+		nblk->szflag |= SZFLAG_FPREVFREE;
+
+	qlink(arena, blk);
+}
+
+/* The master of a movable block, or NULL if blk isn't one */
+static struct qmaster *qhowner(qarena_t *arena, qblock_t *blk) {
+	struct qmaster **payload = BLK_PAYLOAD(blk);
+	struct qmaster *m;
+
+	if (!arena->handles || BLK_SZ(blk) < sizeof(qblock_t) + sizeof(struct qmaster *))
+		return NULL;
+
+	m = *payload;
+	if (m < arena->handles || m >= arena->handles + QALLOC_NHANDLES)
+		return NULL;
+	if (((char *)m - (char *)arena->handles) % sizeof(struct qmaster))
+		return NULL;
+
+	return m->ptr == payload + 1 ? m : NULL;
+}
+
+static unsigned qbin(unsigned size) {
+	unsigned bin = 31 - __builtin_clz(size) - 4;
+
+	return bin < QALLOC_NBINS ? bin : QALLOC_NBINS - 1;
+}
+
+static void qlink(qarena_t *arena, qblock_t *blk) {
+	unsigned bin = qbin(BLK_SZ(blk));
+	qfreeblock_t *fblk = FBLK(blk);
+
+	fblk->prev = NULL;
+	fblk->next = arena->bins[bin];
+	if (fblk->next)
+		fblk->next->prev = fblk;
+	arena->bins[bin] = fblk;
+	arena->binmap |= 1u << bin;
+	arena->nfree++;
+}
+
+static void qunlink(qarena_t *arena, qblock_t *blk) {
+	unsigned bin = qbin(BLK_SZ(blk));
+	qfreeblock_t *fblk = FBLK(blk);
+
+	if (fblk->prev)
+		fblk->prev->next = fblk->next;
+	else
+		arena->bins[bin] = fblk->next;
+	if (fblk->next)
+		fblk->next->prev = fblk->prev;
+
+	if (!arena->bins[bin])
+		arena->binmap &= ~(1u << bin);
+	arena->nfree--;
 }
 
 static void qcheck(qarena_t *arena, qblock_t *blk) {
@@ -153,6 +446,8 @@ static void qcheck(qarena_t *arena, qblock_t *blk) {
 			panic("qcheck: cookie0 corrupt on free blk");
 		if (blk->cookie1 != ~BLK_COOKIE(arena, blk))
 			panic("qcheck: cookie1 corrupt on free blk");
+		if (BLK_FOOTER(blk) != BLK_SZ(blk))
+			panic("qcheck: boundary tag corrupt on free blk");
 	} else {
 		if (blk->cookie0 != ~BLK_COOKIE(arena, blk))
 			panic("qcheck: cookie0 corrupt on alloc blk");
@@ -163,9 +458,9 @@ static void qcheck(qarena_t *arena, qblock_t *blk) {
 #ifdef HEAP_PARANOID
 	if (BLK_ISFREE(blk)) {
 		unsigned i;
-		uint8_t *p = BLK_PAYLOAD(blk);
-		
-		for (i = 0; i < BLK_SZ(blk) - sizeof(qblock_t); i++)
+		uint8_t *p = (uint8_t *)blk + sizeof(qfreeblock_t);
+
+		for (i = 0; i < BLK_SZ(blk) - MINBSZ; i++)
 			if (p[i] != 0xAA) {
 				printf("%08x %08x %08x %02x\n", p, i, &p[i], p[i]);
 				panic("qcheck: paranoia pays off -- heap corruption deep inside free block");
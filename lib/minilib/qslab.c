@@ -0,0 +1,142 @@
+/* qslab.c
+ * Fixed-size object slabs on top of a qalloc arena
+ *
+ * Public domain; optionally see LICENSE
+ */
+
+#include <minilib.h>
+#include <qslab.h>
+#include <debug.h>
+
+/*
+ * Objects of one size are carved out of pages, each page being a single
+ * qalloc block holding perpage objects.  Every object slot is preceded by
+ * a pointer back to its page, so free() finds the page without a search.
+ * Free slots are kept on a per-page list threaded through the object
+ * itself, and pages with free slots are kept on the slab's partial list,
+ * so alloc and free are both O(1).  A page that empties is handed back
+ * to the arena, unless it is the last one with room.
+ */
+
+typedef struct qslabpage {
+	struct qslabpage *next;
+	struct qslabpage *prev;
+	void *free;
+	unsigned short inuse;
+} qslabpage_t;
+
+typedef struct qslabslot {
+	qslabpage_t *page;
+	/* object follows */
+} qslabslot_t;
+
+#define ALIGN(s)	((s + 3) & ~3)
+
+#define SLOT_PAYLOAD(slot)	((void *)((char *)(slot) + sizeof(qslabslot_t)))
+#define SLOT_FROMPAYLOAD(p)	((qslabslot_t *)((char *)(p) - sizeof(qslabslot_t)))
+#define PAGE_SLOT(page, i, stride)	((qslabslot_t *)((char *)((page) + 1) + (i) * (stride)))
+
+static void qslab_link(qslab_t *slab, qslabpage_t *page);
+static void qslab_unlink(qslab_t *slab, qslabpage_t *page);
+static qslabpage_t *qslab_grow(qslab_t *slab);
+
+void qslab_init(qslab_t *slab, qarena_t *arena, unsigned objsz, unsigned perpage) {
+	/* free slots keep their next pointer in the object */
+	if (objsz < sizeof(void *))
+		objsz = sizeof(void *);
+
+	slab->arena = arena;
+	slab->stride = ALIGN(objsz) + sizeof(qslabslot_t);
+	slab->perpage = perpage;
+	slab->partial = NULL;
+	slab->pages = 0;
+	slab->inuse = 0;
+}
+
+void *qslab_alloc(qslab_t *slab) {
+	qslabpage_t *page = slab->partial;
+	qslabslot_t *slot;
+
+	if (!page) {
+		page = qslab_grow(slab);
+		if (!page)
+			return NULL;
+	}
+
+	slot = page->free;
+	page->free = *(void **)SLOT_PAYLOAD(slot);
+	page->inuse++;
+	slab->inuse++;
+
+	if (!page->free)
+		qslab_unlink(slab, page);
+
+	return SLOT_PAYLOAD(slot);
+}
+
+void qslab_free(qslab_t *slab, void *ptr) {
+	if (!ptr)
+		return;
+
+	qslabslot_t *slot = SLOT_FROMPAYLOAD(ptr);
+	qslabpage_t *page = slot->page;
+
+	if (!page || !page->inuse)
+		panic("qslab_free: bad object");
+
+	if (!page->free)
+		qslab_link(slab, page);
+
+	*(void **)ptr = page->free;
+	page->free = slot;
+	page->inuse--;
+	slab->inuse--;
+
+	/* give an empty page back, as long as there's another with room */
+	if (!page->inuse && (slab->partial != page || page->next)) {
+		qslab_unlink(slab, page);
+		qfree(slab->arena, page);
+		slab->pages--;
+	}
+}
+
+/* Private functions */
+
+static qslabpage_t *qslab_grow(qslab_t *slab) {
+	qslabpage_t *page = qalloc(slab->arena, sizeof(qslabpage_t) + slab->perpage * slab->stride);
+	unsigned i;
+
+	if (!page)
+		return NULL;
+
+	page->free = NULL;
+	page->inuse = 0;
+	for (i = slab->perpage; i > 0; i--) {
+		qslabslot_t *slot = PAGE_SLOT(page, i - 1, slab->stride);
+		slot->page = page;
+		*(void **)SLOT_PAYLOAD(slot) = page->free;
+		page->free = slot;
+	}
+
+	qslab_link(slab, page);
+	slab->pages++;
+
+	return page;
+}
+
+static void qslab_link(qslab_t *slab, qslabpage_t *page) {
+	page->prev = NULL;
+	page->next = slab->partial;
+	if (page->next)
+		page->next->prev = page;
+	slab->partial = page;
+}
+
+static void qslab_unlink(qslab_t *slab, qslabpage_t *page) {
+	if (page->prev)
+		page->prev->next = page->next;
+	else
+		slab->partial = page->next;
+	if (page->next)
+		page->next->prev = page->prev;
+}
@@ -239,7 +239,8 @@ static void huffman_tree_init(huffman_tree* tree, uint16_t* buffer, uint16_t num
 /*given the code lengths (as stored in the PNG file), generate the tree as defined by Deflate. maxbitlen is the maximum bits that a code in the tree can have. return value is error.*/
 static void huffman_tree_create_lengths(upng_t* upng, huffman_tree* tree, const uint16_t *bitlen)
 {
-        uint16_t* tree1d = app_malloc(sizeof(uint16_t) * MAX_SYMBOLS);
+        frame_mark_t mark = app_frame_mark();
+        uint16_t* tree1d = app_frame_alloc(sizeof(uint16_t) * MAX_SYMBOLS);
 uint16_t blcount[MAX_BIT_LENGTH];
 uint16_t nextcode[MAX_BIT_LENGTH];
         //unsigned* blcount = app_malloc(sizeof(unsigned) * MAX_BIT_LENGTH);
@@ -309,7 +310,7 @@ if (!tree1d) {
                         tree->tree2d[n] = 0;	/*remove possible remaining 32767's */
                 }
         }
-        app_free(tree1d);
+        app_frame_release(mark);
         //free(blcount);
         //free(nextcode);
 }
@@ -346,7 +347,8 @@ static void get_tree_inflate_dynamic(upng_t* upng, huffman_tree* codetree, huffm
 
         //unsigned* codelengthcode = (unsigned*)app_malloc(sizeof(unsigned) * NUM_CODE_LENGTH_CODES);
         uint16_t codelengthcode[NUM_CODE_LENGTH_CODES];
-        uint16_t* bitlen = (uint16_t*)app_malloc(sizeof(uint16_t) * NUM_DEFLATE_CODE_SYMBOLS);
+        frame_mark_t mark = app_frame_mark();
+        uint16_t* bitlen = (uint16_t*)app_frame_alloc(sizeof(uint16_t) * NUM_DEFLATE_CODE_SYMBOLS);
         //unsigned* bitlenD = (unsigned*)app_malloc(sizeof(unsigned) * NUM_DISTANCE_SYMBOLS);
         uint16_t bitlenD[NUM_DISTANCE_SYMBOLS];
 
@@ -505,7 +507,7 @@ uint16_t n, hlit, hdist, hclen, i;
                 huffman_tree_create_lengths(upng, codetreeD, bitlenD);
         }
         //free(codelengthcode);
-        app_free(bitlen);
+        app_frame_release(mark);
         //free(bitlenD);
 }
 
@@ -513,7 +515,8 @@ uint16_t n, hlit, hdist, hclen, i;
 static void inflate_huffman(upng_t* upng, unsigned char* out, unsigned long outsize, const unsigned char *in, unsigned long *bp, unsigned long *pos, unsigned long inlength, uint16_t btype)
 {
 //Converted to malloc, was overflowing 2k stack on Pebble
-        uint16_t* codetree_buffer = (uint16_t*)app_malloc(sizeof(uint16_t) * DEFLATE_CODE_BUFFER_SIZE);
+        frame_mark_t mark = app_frame_mark();
+        uint16_t* codetree_buffer = (uint16_t*)app_frame_alloc(sizeof(uint16_t) * DEFLATE_CODE_BUFFER_SIZE);
         uint16_t codetreeD_buffer[DISTANCE_BUFFER_SIZE];
 if (codetree_buffer == NULL) {
                 SET_ERROR(upng, UPNG_ENOMEM);
@@ -624,7 +627,7 @@ if (codetree_buffer == NULL) {
                 }
         }
 
-app_free(codetree_buffer);
+app_frame_release(mark);
 //free(codetreeD_buffer);
 return;
 }
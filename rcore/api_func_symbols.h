@@ -180,7 +180,6 @@ UNIMPL(_persist_read_data);
 UNIMPL(_persist_read_string);
 UNIMPL(_persist_write_data);
 UNIMPL(_dict_size);
-UNIMPL(_n_graphics_text_layout_get_content_size);
 UNIMPL(_accel_data_service_subscribe);
 UNIMPL(_menu_layer_legacy2_set_callbacks);
 UNIMPL(_number_window_get_window);
@@ -194,7 +193,6 @@ UNIMPL(_app_worker_launch);
 UNIMPL(_app_worker_message_subscribe);
 UNIMPL(_app_worker_message_unsubscribe);
 UNIMPL(_app_worker_send_message);
-UNIMPL(_worker_event_loop);
 UNIMPL(_worker_launch_app);
 UNIMPL(_heap_bytes_free);
 UNIMPL(_heap_bytes_used);
@@ -846,7 +844,7 @@ const VoidFunc sym[] = {
     [312] = (UnimplFunc)_persist_read_string,                                                  // persist_read_string@000004e0
     [313] = (UnimplFunc)_persist_write_data,                                                   // persist_write_data@000004e4
     [314] = (UnimplFunc)_dict_size,                                                            // dict_size@000004e8
-    [315] = (UnimplFunc)_n_graphics_text_layout_get_content_size,                              // graphics_text_layout_get_content_size@000004ec
+    [315] = (VoidFunc)n_graphics_text_layout_get_content_size,                                 // graphics_text_layout_get_content_size@000004ec
     [317] = (UnimplFunc)_accel_data_service_subscribe,                                         // accel_data_service_subscribe@000004f4
     [320] = (UnimplFunc)_menu_layer_legacy2_set_callbacks,                                     // menu_layer_legacy2_set_callbacks@00000500
     [322] = (UnimplFunc)_number_window_get_window,                                             // number_window_get_window@00000508
@@ -860,7 +858,7 @@ const VoidFunc sym[] = {
     [330] = (UnimplFunc)_app_worker_message_subscribe,                                         // app_worker_message_subscribe@00000528
     [331] = (UnimplFunc)_app_worker_message_unsubscribe,                                       // app_worker_message_unsubscribe@0000052c
     [332] = (UnimplFunc)_app_worker_send_message,                                              // app_worker_send_message@00000530
-    [333] = (UnimplFunc)_worker_event_loop,                                                    // worker_event_loop@00000534
+    [333] = (VoidFunc)worker_event_loop,                                                       // worker_event_loop@00000534
     [334] = (UnimplFunc)_worker_launch_app,                                                    // worker_launch_app@00000538
     [335] = (UnimplFunc)_heap_bytes_free,                                                      // heap_bytes_free@0000053c
     [336] = (UnimplFunc)_heap_bytes_used,                                                      // heap_bytes_used@00000540
@@ -43,8 +43,8 @@ static StackType_t _app_thread_manager_stack[APP_THREAD_MANAGER_STACK_SIZE];  //
  * or at least add dynamicness to it. But honestly we have 3 threads
  * max at the moment, so if we get there, maybe */
 static uint8_t _heap_app[MEMORY_SIZE_APP_HEAP];
-static CCRAM uint8_t _heap_worker[MEMORY_SIZE_WORKER_HEAP];
-static CCRAM uint8_t _heap_overlay[MEMORY_SIZE_OVERLAY_HEAP];
+static CCRAM_BSS uint8_t _heap_worker[MEMORY_SIZE_WORKER_HEAP];
+static CCRAM_BSS uint8_t _heap_overlay[MEMORY_SIZE_OVERLAY_HEAP];
 
 /* keep these stacks off CCRAM */
 static StackType_t _stack_app[MEMORY_SIZE_APP_STACK];
@@ -61,7 +61,7 @@ static app_running_thread _app_threads[MAX_APP_THREADS] = {
         .stack_size = MEMORY_SIZE_APP_STACK,
         .stack = _stack_app,
         .thread_entry = &appmanager_app_main_entry,
-        .thread_priority = 6UL,
+        .thread_priority = 4UL,
     },
     {
         .thread_type = AppThreadWorker,
@@ -70,8 +70,8 @@ static app_running_thread _app_threads[MAX_APP_THREADS] = {
         .heap = _heap_worker,
         .stack_size = MEMORY_SIZE_WORKER_STACK,
         .stack = _stack_worker,
-        /*.thread_entry = &appmanager_worker_main_entry */
-        .thread_priority = 8UL,
+        .thread_entry = &appmanager_app_main_entry,
+        .thread_priority = 4UL,
     },
     {
         .thread_type = AppThreadOverlay,
@@ -80,7 +80,7 @@ static app_running_thread _app_threads[MAX_APP_THREADS] = {
         .heap = _heap_overlay,
         .stack_size = MEMORY_SIZE_OVERLAY_STACK,
         .stack = _stack_overlay,
-        .thread_priority = 9UL,
+        .thread_priority = 4UL,
     }
 };
 
@@ -98,7 +98,7 @@ void appmanager_init(void)
                                                         "App", 
                                                         APP_THREAD_MANAGER_STACK_SIZE, 
                                                         NULL, 
-                                                        tskIDLE_PRIORITY + 5UL, 
+                                                        tskIDLE_PRIORITY + 4UL, 
                                                         _app_thread_manager_stack, 
                                                         &_app_thread_manager_task);
     
@@ -107,6 +107,69 @@ void appmanager_init(void)
 
 
 
+/*
+ * Join two timer heaps, the later root becoming the first child of
+ * the earlier one. Both roots must have no parent or siblings
+ */
+static CoreTimer *_timer_merge(CoreTimer *a, CoreTimer *b)
+{
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+    
+    if (b->when < a->when)
+    {
+        CoreTimer *t = a;
+        a = b;
+        b = t;
+    }
+    
+    b->prev = a;
+    b->sibling = a->child;
+    if (a->child)
+        a->child->prev = b;
+    a->child = b;
+    
+    return a;
+}
+
+/*
+ * Join a list of sibling heaps into one: merge them in pairs left to
+ * right, then fold the pairs together right to left. Done in a loop
+ * rather than recursively, so thousands of timers don't eat the app stack
+ */
+static CoreTimer *_timer_merge_pairs(CoreTimer *first)
+{
+    CoreTimer *pairs = NULL;
+    
+    while (first)
+    {
+        CoreTimer *a = first;
+        CoreTimer *b = a->sibling;
+        first = b ? b->sibling : NULL;
+        
+        a->sibling = a->prev = NULL;
+        if (b)
+            b->sibling = b->prev = NULL;
+        
+        a = _timer_merge(a, b);
+        a->sibling = pairs;
+        pairs = a;
+    }
+    
+    CoreTimer *root = NULL;
+    while (pairs)
+    {
+        CoreTimer *next = pairs->sibling;
+        pairs->sibling = NULL;
+        root = _timer_merge(pairs, root);
+        pairs = next;
+    }
+    
+    return root;
+}
+
 /* 
  * Always adds to the running app's queue.  Note that this is only
  * reasonable to do from the app thread: otherwise, you can race with the
@@ -115,48 +178,51 @@ void appmanager_init(void)
 void appmanager_timer_add(CoreTimer *timer)
 {
     app_running_thread *_this_thread = appmanager_get_current_thread();
-    CoreTimer **tnext = &_this_thread->timer_head;
-    
-    /* until either the next pointer is null (i.e., we have hit the end of
-     * the list), or the thing that the next pointer points to is further in
-     * the future than we are (i.e., we want to insert before the thing that
-     * the next pointer points to)
-     */
-    while (*tnext && (timer->when > (*tnext)->when)) {
-        tnext = &((*tnext)->next);
-    }
     
-    timer->next = *tnext;
-    *tnext = timer;
+    timer->child = timer->sibling = timer->prev = NULL;
+    _this_thread->timer_head = _timer_merge(_this_thread->timer_head, timer);
 }
 
 void appmanager_timer_remove(CoreTimer *timer)
 {
     app_running_thread *_this_thread = appmanager_get_current_thread();
-    CoreTimer **tnext = &_this_thread->timer_head;
     
-    while (*tnext) {
-        if (*tnext == timer) {
-            *tnext = timer->next;
-            return;
-        }
-        tnext = &(*tnext)->next;
+    if (timer == _this_thread->timer_head)
+    {
+        _this_thread->timer_head = _timer_merge_pairs(timer->child);
+    }
+    else
+    {
+        /* only the top of the heap has nothing before it */
+        assert(timer->prev && "appmanager_timer_remove did not find timer in list");
+        
+        /* cut our subtree out, then merge what was below us back in */
+        if (timer->prev->child == timer)
+            timer->prev->child = timer->sibling;
+        else
+            timer->prev->sibling = timer->sibling;
+        if (timer->sibling)
+            timer->sibling->prev = timer->prev;
+        
+        _this_thread->timer_head = _timer_merge(_this_thread->timer_head,
+                                                _timer_merge_pairs(timer->child));
     }
     
-    assert(!"appmanager_timer_remove did not find timer in list");
+    timer->child = timer->sibling = timer->prev = NULL;
 }
 
+/*
+ * Every app task stashes its thread in task local storage when it starts,
+ * so this is a load from the TCB, not a search. It's on the path of every
+ * app_malloc. System tasks have nothing there and get NULL
+ */
 app_running_thread *_get_current_thread(void)
 {
-    TaskHandle_t this_task = xTaskGetCurrentTaskHandle();
+    /* logging can get here before there are any tasks at all */
+    if (xTaskGetCurrentTaskHandle() == NULL)
+        return NULL;
     
-    for (uint8_t i = 0; i < MAX_APP_THREADS; i++)
-    {
-        if (_app_threads[i].task_handle == this_task)
-            return &_app_threads[i];
-    }
-    
-    return NULL;
+    return pvTaskGetThreadLocalStoragePointer(NULL, APPMANAGER_TLS_THREAD);
 }
 
 /*
@@ -227,6 +293,212 @@ bool appmanager_is_thread_worker(void)
     return appmanager_get_thread_type() == AppThreadWorker;
 }
 
+/* How long an app gets to quit when asked, before we kill it */
+#define APP_QUIT_TIMEOUT_MS 5000
+
+/* How long the app runloop can spend on one batch of work before the
+ * watchdog decides it has hung. The app threads, the manager and the
+ * watchdog task all share priority 4 and time slice, so an app spinning
+ * flat out is caught too, not just one blocked for good */
+#define APP_HANG_TIMEOUT_MS 5000
+
+/* The app to start on each thread once the current one has gone */
+static char *_app_pending[MAX_APP_THREADS];
+
+/*
+ * Kill the thread's task where it stands. It can't give back the
+ * framebuffer lock itself if it dies holding it, so we do
+ */
+static void _app_delete_task(app_running_thread *thread)
+{
+    vTaskDelete(thread->task_handle);
+    display_buffer_lock_release_task(thread->task_handle);
+    thread->task_handle = NULL;
+}
+
+/*
+ * Load an app onto an idle thread and start it running
+ */
+static void _app_start(app_running_thread *thread, char *app_name)
+{
+    ApplicationHeader header;
+    uint32_t total_app_size = 0;
+    TickType_t start = xTaskGetTickCount();
+    
+    KERN_LOG("app", APP_LOG_LEVEL_INFO, "Starting app %s", app_name);
+    
+    if (app_manager_get_apps_head() == NULL)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "No Apps found!");
+        assert(!"No Apps");
+        return;
+    }
+    
+    App *app = appmanager_get_app(app_name);
+    
+    if (app == NULL)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "App %s NOT found!", app_name);
+        assert(!"App not found!");
+        return;
+    }
+    
+    thread->status = AppThreadLoading;
+    
+    /*  TODO reset clicks */
+    tick_timer_service_unsubscribe();
+
+    /* We have an app that's at least known. push on with loading it */
+    thread->app = app;
+    thread->timer_head = NULL;
+    thread->shutdown_at_tick = 0;
+    thread->busy_since = 0;
+    
+    /* At this point the existing task should be gone already
+     * If it isn't we kill it. Lets complain though, becuase it's
+     * broken if we are here */
+    if (thread->task_handle != NULL) {
+        _app_delete_task(thread);
+        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "The previous task was still running. FIXME");
+    }
+    
+    /* anything left queued was for the app before */
+    if (thread->thread_type == AppThreadMainApp)
+        appmanager_app_runloop_reset();
+    
+    /* If the app is running off RAM (i.e it's a PIC loaded app...) 
+    * and not system, we need to patch it */
+    if (!app->is_internal)
+    {
+        appmanager_load_app(thread, &header);
+        total_app_size = header.virtual_size;
+    }
+    
+    /* Execute the app we just loaded */
+    appmanager_execute_app(thread, total_app_size);
+    
+    /* app_name may have pointed into the heap the old app just lost */
+    KERN_LOG("app", APP_LOG_LEVEL_INFO, "Started %s in %dms", app->name,
+             (xTaskGetTickCount() - start) * portTICK_PERIOD_MS);
+}
+
+/*
+ * The thread's task is done with, one way or another. Free the thread up
+ * and start whatever was waiting for it
+ */
+static void _app_finished(app_running_thread *thread)
+{
+    if (thread->task_handle)
+        _app_delete_task(thread);
+    thread->shutdown_at_tick = 0;
+    thread->app = NULL;
+    thread->status = AppThreadUnloaded;
+    
+    char *next = _app_pending[thread->thread_type];
+    _app_pending[thread->thread_type] = NULL;
+    if (next)
+        _app_start(thread, next);
+}
+
+/*
+ * Ask the thread's app to quit, and give it a deadline to
+ */
+static void _app_request_quit(app_running_thread *thread)
+{
+    if (thread->shutdown_at_tick == 0)
+        thread->shutdown_at_tick = xTaskGetTickCount() + pdMS_TO_TICKS(APP_QUIT_TIMEOUT_MS);
+    
+    /* the main app is asked through its runloop. A worker is woken
+     * out of worker_event_loop; if it hasn't got there yet, the
+     * notification waits for it */
+    if (thread->thread_type == AppThreadMainApp)
+        appmanager_app_quit();
+    else if (thread->thread_type == AppThreadWorker && thread->task_handle)
+        xTaskNotifyGive(thread->task_handle);
+}
+
+/*
+ * Someone wants an app started on a thread. If the thread is free we
+ * start it now, otherwise it goes in once the current app has gone.
+ * Asking again before then just changes which app that is
+ */
+static void _app_load_requested(app_running_thread *thread, char *app_name)
+{
+    switch (thread->status)
+    {
+        case AppThreadUnloaded:
+            _app_start(thread, app_name);
+            break;
+        case AppThreadLoading:
+        case AppThreadLoaded:
+            _app_pending[thread->thread_type] = app_name;
+            _app_request_quit(thread);
+            break;
+        case AppThreadUnloading:
+            KERN_LOG("app", APP_LOG_LEVEL_INFO, "Waiting for app to close...");
+            _app_pending[thread->thread_type] = app_name;
+            break;
+    }
+}
+
+/*
+ * The app is wedged or has gone wrong; kill its task outright. The main
+ * app thread is never left empty, so if nothing was waiting to run we go
+ * back to the launcher
+ */
+static void _app_crashed(app_running_thread *thread)
+{
+    KERN_LOG("app", APP_LOG_LEVEL_ERROR, "!! Hard terminating app");
+    
+    if (thread->thread_type == AppThreadMainApp &&
+        _app_pending[thread->thread_type] == NULL)
+        _app_pending[thread->thread_type] = "System";
+    
+    _app_finished(thread);
+}
+
+/*
+ * Called from the watchdog task. If the app's runloop has been stuck on
+ * one batch of work for too long, it isn't coming back; have it killed
+ */
+void appmanager_watchdog_check(void)
+{
+    app_running_thread *thread = &_app_threads[AppThreadMainApp];
+    TickType_t since = thread->busy_since;
+    
+    if (thread->status != AppThreadLoaded || since == 0 ||
+        xTaskGetTickCount() - since < pdMS_TO_TICKS(APP_HANG_TIMEOUT_MS))
+        return;
+    
+    KERN_LOG("app", APP_LOG_LEVEL_ERROR, "App runloop hung for %dms",
+             (xTaskGetTickCount() - since) * portTICK_PERIOD_MS);
+    /* the once is enough */
+    thread->busy_since = 0;
+    appmanager_app_crashed(AppThreadMainApp);
+}
+
+/*
+ * How long until the next quit deadline, if any app is quitting
+ */
+static TickType_t _app_next_deadline(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    TickType_t next = portMAX_DELAY;
+    
+    for (uint8_t i = 0; i < MAX_APP_THREADS; i++)
+    {
+        TickType_t at = _app_threads[i].shutdown_at_tick;
+        if (at == 0)
+            continue;
+        if (at <= now)
+            return 0;
+        if (at - now < next)
+            next = at - now;
+    }
+    
+    return next;
+}
+
 /*
  * A task to run an application.
  * 
@@ -238,113 +510,32 @@ bool appmanager_is_thread_worker(void)
  * The new task is created with a statically allocated array of it's memory size
  * This array is used as the heap and the stack.
  * refer to heap_app.c (for now, until the refactor) TODO
- * Once handoff is done, we sleep waitiing for a new job or something to kill
  * 
- * TODO
- * running thread ping pong for aliveness
- * Change out the kill timer for a local kill sleep
+ * Each thread moves Unloaded -> Loading -> Loaded -> Unloading -> Unloaded,
+ * driven by the messages we are sent: an app to start, an app that has
+ * exited, or one that has crashed. Each is acted on as soon as it comes in.
+ * The only time we wake up on our own is when an app we asked to quit has
+ * run out of time to do so
  */
 static void _app_management_thread(void *parms)
 {
-    ApplicationHeader header;   /* TODO change to malloc so we can free after load? */
-    char *app_name;
     AppMessage am;
-    uint32_t total_app_size = 0;
     app_running_thread *_this_thread = NULL;   
     
     for( ;; )
     {
         /* Sleep waiting for work to do */
-        if (xQueueReceive(_app_thread_queue, &am, pdMS_TO_TICKS(1000)))
+        if (xQueueReceive(_app_thread_queue, &am, _app_next_deadline()))
         {        
+            _this_thread = &_app_threads[am.thread_id];
+            
             switch(am.message_type_id)
             {
                 /* Load an app for someone. face or worker */
                 case THREAD_MANAGER_APP_LOAD:
-                    app_name = (char *)am.payload;
-                    _this_thread = &_app_threads[am.thread_id];
-                    
-                    if (_this_thread->status == AppThreadLoading || 
-                        _this_thread->status == AppThreadLoaded)
-                    {
-                        /* post an app quit to the running process
-                         * then immediately post our received message back onto 
-                         * the queue behind the quit. 
-                         * Once the app is quit, we will continue 
-                         * TODO we could go around this merry-go-round for a while
-                         * we should track that or use a better mechanism.
-                         * in reality this isn't a big issue. A concern maybe
-                         */
-                        appmanager_app_quit();
-                        xQueueSendToBack(_app_thread_queue, &am, (TickType_t)100);
-                        continue;
-                    }
-                    else if (_this_thread->status == AppThreadUnloading)
-                    {
-                        /* it's closing down, keep reposting the message 
-                         * until we are free to launch 
-                         * TODO: this is pretty weak 
-                         * Make this a proper state machine, wait on completion 
-                         * and launch the app
-                         */
-                        KERN_LOG("app", APP_LOG_LEVEL_INFO, "Waiting for app to close...");
-                        xQueueSendToBack(_app_thread_queue, &am, (TickType_t)100);
-                        continue;
-                    }
-                    
-                    KERN_LOG("app", APP_LOG_LEVEL_INFO, "Starting app %s", app_name);
-                    _this_thread->status = AppThreadLoading;
-                        
-                    /*  TODO reset clicks */
-                    tick_timer_service_unsubscribe();
-                    
-                    if (app_manager_get_apps_head() == NULL)
-                    {
-                        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "No Apps found!");
-                        assert(!"No Apps");
-                        return;
-                    }
-                    
-                    App *app = appmanager_get_app(app_name);
-                    
-                    if (app == NULL)
-                    {
-                        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "App %s NOT found!", app_name);
-                        assert(!"App not found!");
-                        continue;
-                    }
-
-                    /* We have an app that's at least known. push on with loading it */
-                    _this_thread->app = app;
-                    _this_thread->timer_head = NULL;
-                    
-                    /* At this point the existing task should be gone already
-                     * If it isn't we kill it. Lets complain though, becuase it's
-                     * broken if we are here */
-                    if (_this_thread->task_handle != NULL) {
-                        vTaskDelete(_this_thread->task_handle);
-                        _this_thread->task_handle = NULL;
-                        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "The previous task was still running. FIXME");
-                    }
-                    
-                    /* If the app is running off RAM (i.e it's a PIC loaded app...) 
-                    * and not system, we need to patch it */
-                    if (!app->is_internal)
-                    {
-                        appmanager_load_app(_this_thread, &header);
-                        total_app_size = header.virtual_size;
-                    }
-                    else
-                    {
-                        total_app_size = 0;
-                    }
-                    
-                    /* Execute the app we just loaded */
-                    appmanager_execute_app(_this_thread, total_app_size);
+                    _app_load_requested(_this_thread, (char *)am.payload);
                     break;
                 case THREAD_MANAGER_APP_QUIT_CLEAN:
-                    _this_thread = &_app_threads[am.thread_id];
-                    
                     if (_this_thread->status != AppThreadUnloading)
                         KERN_LOG("app", APP_LOG_LEVEL_WARNING, "Unloading app while not in correct state!");
                     
@@ -352,31 +543,23 @@ static void _app_management_thread(void *parms)
                     KERN_LOG("app", APP_LOG_LEVEL_DEBUG, "App finished cleanly");
                     
                     /* The task will die hard, but it did finish the runloop */
-                    vTaskDelete(_this_thread->task_handle);
-                    _this_thread->task_handle = NULL;
-                    _this_thread->shutdown_at_tick = 0;
-                    _this_thread->app = NULL;
-                    _this_thread->status = AppThreadUnloaded;
+                    _app_finished(_this_thread);
+                    break;
+                case THREAD_MANAGER_APP_CRASHED:
+                    _app_crashed(_this_thread);
                     break;
             }        
         }
         else
         {
-            /* We woke up to check if we need to kill anything */
-            /* check all threads */
+            /* An app we asked to quit is out of time */
+            TickType_t now = xTaskGetTickCount();
             for (uint8_t i = 0; i < MAX_APP_THREADS; i++)
             {
                 _this_thread = &_app_threads[i];
                 if (_this_thread->shutdown_at_tick > 0 &&
-                        xTaskGetTickCount() >= _this_thread->shutdown_at_tick)
-                {
-                    KERN_LOG("app", APP_LOG_LEVEL_ERROR, "!! Hard terminating app");
-                    
-                    vTaskDelete(_this_thread->task_handle);
-                    _this_thread->shutdown_at_tick = 0;
-                    _this_thread->status = AppThreadUnloaded;
-                }
-                /* app really should have died by now */
+                        now >= _this_thread->shutdown_at_tick)
+                    _app_crashed(_this_thread);
             }
         }
 
@@ -385,6 +568,125 @@ static void _app_management_thread(void *parms)
 }
 
 
+/*
+ * Relocated app images, kept so that relaunching an app at the address it
+ * ran from before skips the flash read and the relocation pass.
+ * An image is only good for the same binary (crc) loaded at the same place,
+ * and is copied before the app has had a chance to write to its .data.
+ * They live on the system heap, most recently used first, and never take
+ * it below APP_IMAGE_CACHE_RESERVE. Only the manager thread touches them
+ */
+#if APP_IMAGE_CACHE_SIZE
+
+typedef struct app_image_t {
+    struct app_image_t *next;
+    Uuid uuid;
+    uint32_t crc;
+    uint8_t *base;
+    uint16_t size;
+    uint8_t image[];
+} app_image_t;
+
+static app_image_t *_app_images;
+static size_t _app_images_size;
+
+static void _app_image_drop(app_image_t **prev)
+{
+    app_image_t *image = *prev;
+    
+    *prev = image->next;
+    _app_images_size -= image->size;
+    system_free(image);
+}
+
+static bool _app_image_restore(app_running_thread *thread, ApplicationHeader *header)
+{
+    for (app_image_t **prev = &_app_images; *prev; prev = &(*prev)->next)
+    {
+        app_image_t *image = *prev;
+        
+        if (image->base != thread->heap || image->crc != header->crc ||
+            memcmp(&image->uuid, &header->uuid, sizeof(Uuid)))
+            continue;
+        
+        if (image->size != header->app_size)
+            break;
+        
+        memcpy(thread->heap, image->image, image->size);
+        
+        /* to the front, it's the one we want to keep */
+        *prev = image->next;
+        image->next = _app_images;
+        _app_images = image;
+        
+        KERN_LOG("app", APP_LOG_LEVEL_DEBUG, "Image cache: hit, %d bytes", image->size);
+        return true;
+    }
+    
+    return false;
+}
+
+static void _app_image_save(app_running_thread *thread, ApplicationHeader *header)
+{
+    app_image_t **prev = &_app_images;
+    
+    /* any other copy of this app is out of date or in the wrong place */
+    while (*prev)
+    {
+        if (!memcmp(&(*prev)->uuid, &header->uuid, sizeof(Uuid)))
+            _app_image_drop(prev);
+        else
+            prev = &(*prev)->next;
+    }
+    
+    if (header->app_size > APP_IMAGE_CACHE_SIZE)
+        return;
+    
+    /* make room by throwing away the least recently used */
+    while (_app_images && _app_images_size + header->app_size > APP_IMAGE_CACHE_SIZE)
+    {
+        for (prev = &_app_images; (*prev)->next; prev = &(*prev)->next)
+            ;
+        _app_image_drop(prev);
+    }
+    
+    size_t size = sizeof(app_image_t) + header->app_size;
+    
+    if (xPortGetFreeHeapSize() < size + APP_IMAGE_CACHE_RESERVE)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_DEBUG, "Image cache: no room for %d bytes", header->app_size);
+        return;
+    }
+    
+    app_image_t *image = system_malloc(size);
+    if (!image)
+        return;
+    
+    memcpy(&image->uuid, &header->uuid, sizeof(Uuid));
+    image->crc = header->crc;
+    image->base = thread->heap;
+    image->size = header->app_size;
+    memcpy(image->image, thread->heap, header->app_size);
+    
+    image->next = _app_images;
+    _app_images = image;
+    _app_images_size += image->size;
+}
+
+#else
+
+static bool _app_image_restore(app_running_thread *thread, ApplicationHeader *header)
+{
+    return false;
+}
+
+static void _app_image_save(app_running_thread *thread, ApplicationHeader *header)
+{
+}
+
+#endif
+
+
 /*
     Heres what is going down. We are going to load the app from flash.
     The app is stored in flash and is a butchered ELF position independant
@@ -451,6 +753,7 @@ static void _app_management_thread(void *parms)
 void appmanager_load_app(app_running_thread *thread, ApplicationHeader *header)
 {   
     struct fd fd;
+    uint32_t bss_size;
     
     /* de-fluff */
     memset(thread->heap, 0, thread->heap_size);
@@ -458,6 +761,10 @@ void appmanager_load_app(app_running_thread *thread, ApplicationHeader *header)
     fs_open(&fd, &thread->app->app_file);
     fs_read(&fd, header, sizeof(ApplicationHeader));
 
+    /* seen this one at this address before? Then it's already relocated */
+    if (_app_image_restore(thread, header))
+        goto loaded;
+
     /* load the app from flash
      *  and any reloc entries too. */
     fs_seek(&fd, 0, FS_SEEK_SET);
@@ -504,8 +811,12 @@ void appmanager_load_app(app_running_thread *thread, ApplicationHeader *header)
         }
     }
     
+    /* keep it as it is now, before the app gets to touch its .data */
+    _app_image_save(thread, header);
+
+loaded:
     /* init bss to 0. We already zeros all of the heap, so only reset the reloc table */
-    uint32_t bss_size = header->virtual_size - header->app_size;
+    bss_size = header->virtual_size - header->app_size;
     
     memset(thread->heap + header->app_size, 0, header->reloc_entries_count * 4);
     memset(thread->stack, 0, thread->stack_size * 4);
@@ -559,12 +870,16 @@ void appmanager_execute_app(app_running_thread *thread, uint32_t total_app_size)
     
     /* heap is all uint8_t */
     thread->arena = qinit(heap_entry, heap_size);
+    /* the old frame arena and pools went with the old heap */
+    memset(&thread->frame, 0, sizeof(frame_arena_t));
+    memset(thread->pools, 0, sizeof(thread->pools));
     
     /* DANGER fix this properly. It should not reset here (overlay might be using it) */
     rwatch_neographics_init();
     
-    /* Load the app in a vTask */
-    xTaskCreateStatic(_appmanager_thread_init, 
+    /* Load the app in a vTask. The task sets its handle again when it
+     * runs, but a quit request can need it before then */
+    thread->task_handle = xTaskCreateStatic(_appmanager_thread_init, 
                         "dynapp", 
                         thread->stack_size, 
                         (void *)thread, 
@@ -578,6 +893,7 @@ static void _appmanager_thread_init(void *thread_handle)
     app_running_thread *thread = (app_running_thread *)thread_handle;
     assert(thread && "Invalid thread on init!");
     thread->task_handle = xTaskGetCurrentTaskHandle();
+    vTaskSetThreadLocalStoragePointer(NULL, APPMANAGER_TLS_THREAD, thread);
     ((VoidFunc)thread->thread_entry)();
 }
 
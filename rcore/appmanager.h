@@ -13,17 +13,22 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "qalloc.h"
+#include "rebble_memory.h"
 #include <stdbool.h>
 
 // TODO     Make this dynamic. hacky 
 #define NUM_APPS 3
 #define MAX_APP_STR_LEN 32
 
+/* A thread's timers are kept in a pairing heap with the soonest at the
+ * top, so adding one is O(1) and removing one O(log n) amortised */
 typedef struct CoreTimer
 {
     TickType_t when; /* ticks when this should fire, in ticks since boot */
     void (*callback)(struct CoreTimer *); /* always called back on the app thread */
-    struct CoreTimer *next;
+    struct CoreTimer *child;   /* first of the timers due after us */
+    struct CoreTimer *sibling; /* next timer with the same parent */
+    struct CoreTimer *prev;    /* parent if we are its first child, else the sibling before us */
 } CoreTimer;
 
 typedef struct AppMessage
@@ -97,7 +102,10 @@ typedef struct App {
     char *name;
     ApplicationHeader *header;
     AppMainHandler main; // A shortcut to main
+    Uuid uuid; // all zero for the baked in apps
     struct App *next;
+    struct App *name_next; // hash bucket chains
+    struct App *uuid_next;
 } App;
 
 typedef struct AppTypeHeader {
@@ -141,8 +149,12 @@ typedef enum AppThreadType {
 } AppThreadType;
 
 
+/* Task local storage slot holding an app task's app_running_thread */
+#define APPMANAGER_TLS_THREAD 0
+
 #define THREAD_MANAGER_APP_LOAD       0
 #define THREAD_MANAGER_APP_QUIT_CLEAN 1
+#define THREAD_MANAGER_APP_CRASHED    2
 
 /* This struct hold all information about the task that is executing
  * There are many runing apps, such as main app, worker or background.
@@ -153,6 +165,7 @@ typedef struct app_running_thread_t {
     AppThreadState status;
     void *thread_entry;
     TickType_t shutdown_at_tick;
+    TickType_t busy_since;  // when the runloop took on work, 0 while it waits
     const char *thread_name;    
     uint8_t thread_priority;
     TaskHandle_t task_handle;
@@ -163,6 +176,8 @@ typedef struct app_running_thread_t {
     uint8_t *heap;
     struct CoreTimer *timer_head;
     qarena_t *arena;
+    frame_arena_t frame;
+    app_pool_t pools[AppPoolCount];
 } app_running_thread;
 
 /* in appmanager.c */
@@ -170,6 +185,7 @@ void appmanager_init(void);
 void appmanager_timer_add(CoreTimer *timer);
 void appmanager_timer_remove(CoreTimer *timer);
 void app_event_loop(void);
+void worker_event_loop(void);
 bool appmanager_post_generic_thread_message(AppMessage *am, TickType_t timeout);
 app_running_thread *appmanager_get_current_thread(void);
 App *appmanager_get_current_app(void);
@@ -177,24 +193,46 @@ bool appmanager_is_thread_system(void);
 bool appmanager_is_thread_worker(void);
 bool appmanager_is_thread_app(void);
 bool appmanager_is_thread_overlay(void);
+/* Bytes of system heap that may hold relocated app images for quick
+ * relaunch, and how much of the heap they must always leave free.
+ * 0 turns the cache off */
+#ifndef APP_IMAGE_CACHE_SIZE
+#define APP_IMAGE_CACHE_SIZE 0
+#endif
+#ifndef APP_IMAGE_CACHE_RESERVE
+#define APP_IMAGE_CACHE_RESERVE 8192
+#endif
+
 void appmanager_load_app(app_running_thread *thread, ApplicationHeader *header);
 void appmanager_execute_app(app_running_thread *thread, uint32_t total_app_size);
 app_running_thread *appmanager_get_thread(AppThreadType type);
 AppThreadType appmanager_get_thread_type(void);
+void appmanager_watchdog_check(void);
 
 /* in appmanager_app_runloop.c */
+/* How much the app runloop has handled and drawn, since boot */
+typedef struct app_runloop_stats_t {
+    uint32_t events;
+    uint32_t frames;
+} app_runloop_stats_t;
+
 void appmanager_app_runloop_init(void);
+void appmanager_app_runloop_get_stats(app_runloop_stats_t *stats);
+void appmanager_app_runloop_reset(void);
 void appmanager_app_main_entry(void);
 App *app_manager_get_apps_head();
-void appmanager_post_button_message(ButtonMessage *bmessage);
+bool appmanager_post_button_message(ButtonMessage *bmessage);
 void appmanager_post_draw_message(void);
 void appmanager_app_start(char *name);
+bool appmanager_app_start_by_uuid(const Uuid *uuid);
 void appmanager_app_quit(void);
-void appmanager_post_generic_app_message(AppMessage *am, TickType_t timeout);
+void appmanager_app_crashed(AppThreadType thread_type);
+bool appmanager_post_generic_app_message(AppMessage *am, TickType_t timeout);
 void appmanager_timer_expired(app_running_thread *thread);
 TickType_t appmanager_timer_get_next_expiry(app_running_thread *thread);
 
 /* in appmanager_app.c */
 App *appmanager_get_app(char *app_name);
+App *appmanager_get_app_by_uuid(const Uuid *uuid);
 void appmanager_app_loader_init(void);
 
@@ -14,9 +14,11 @@
 #include "notification.h"
 #include "test_defs.h"
 
+struct app_files_index_t;
+
 static App *_appmanager_create_app(char *name, uint8_t type, void *entry_point, bool is_internal,
                                    const struct file *app_file, const struct file *resource_file);
-static void _appmanager_flash_load_app_manifest();
+static void _appmanager_flash_load_app_manifest(struct app_files_index_t *files);
 static void _appmanager_add_to_manifest(App *app);
 
 /* simple doesn't have an include, so cheekily forward declare here */
@@ -52,7 +54,239 @@ struct appdb
     uint8_t unk_arr[32]; // always blank
 } __attribute__((__packed__));
 
+/* The manifest is kept in load order for listing, and hashed by name and
+ * by UUID for lookups. The tables are sized at boot for however many apps
+ * are on flash, a power of two with at least a bucket per app. If that
+ * alloc fails, one bucket each still works, only slowly */
+#define APP_MANIFEST_BUILTIN 6 /* the baked in apps, in appmanager_app_loader_init */
+
 static App *_app_manifest_head;
+static App *_app_manifest_tail;
+static App *_app_by_name_single;
+static App *_app_by_uuid_single;
+static App **_app_by_name = &_app_by_name_single;
+static App **_app_by_uuid = &_app_by_uuid_single;
+static uint32_t _app_bucket_mask;
+
+/* The app and resource files of one appdb entry, as found on the fs */
+#define APP_FILES_APP 1
+#define APP_FILES_RES 2
+
+typedef struct app_files_t {
+    struct app_files_t *next;
+    uint32_t application_id;
+    struct file app_file;
+    struct file res_file;
+    uint8_t found;
+} app_files_t;
+
+/* Every app_files_t, hashed by application id. The buckets and the nodes
+ * come out of one block, sized by a first pass over the fs that only
+ * counts */
+typedef struct app_files_index_t {
+    app_files_t **buckets;
+    app_files_t *nodes;
+    uint32_t mask;
+    uint16_t size;
+    uint16_t used;
+} app_files_index_t;
+
+static uint32_t _bucket_count(uint32_t entries)
+{
+    uint32_t buckets = 1;
+    
+    while (buckets < entries)
+        buckets <<= 1;
+    
+    return buckets;
+}
+
+/* FNV-1a */
+static uint32_t _app_name_hash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    
+    while (*name)
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    
+    return hash;
+}
+
+/* UUIDs are random enough already */
+static uint32_t _uuid_hash(const Uuid *uuid)
+{
+    const uint8_t *bytes = (const uint8_t *)uuid;
+    
+    return bytes[0] | (bytes[5] << 8) | (bytes[10] << 16) | (bytes[15] << 24);
+}
+
+static bool _uuid_is_empty(const Uuid *uuid)
+{
+    const uint8_t *bytes = (const uint8_t *)uuid;
+    
+    for (uint8_t i = 0; i < sizeof(Uuid); i++)
+        if (bytes[i])
+            return false;
+    
+    return true;
+}
+
+/* Where the appdb turned up in the filesystem walk */
+static struct file _app_files_appdb;
+static bool _app_files_have_appdb;
+
+static app_files_t *_app_files_find(app_files_index_t *files, uint32_t application_id)
+{
+    for (app_files_t *node = files->buckets[application_id & files->mask]; node; node = node->next)
+    {
+        if (node->application_id == application_id)
+            return node;
+    }
+    
+    return NULL;
+}
+
+/*
+ * Is this "@<application id>/app" or "@<application id>/res"? Returns
+ * which, with the id, or 0 for any other file
+ */
+static uint8_t _app_files_parse(const char *name, uint32_t *application_id)
+{
+    *application_id = 0;
+    
+    if (name[0] != '@' || strlen(name) != 13 || name[9] != '/')
+        return 0;
+    
+    for (uint8_t i = 1; i < 9; i++)
+    {
+        char c = name[i];
+        uint8_t nibble;
+        
+        if (c >= '0' && c <= '9')
+            nibble = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            nibble = c - 'a' + 10;
+        else
+            return 0;
+        
+        *application_id = (*application_id << 4) | nibble;
+    }
+    
+    if (!strcmp(name + 10, "app"))
+        return APP_FILES_APP;
+    if (!strcmp(name + 10, "res"))
+        return APP_FILES_RES;
+    return 0;
+}
+
+/*
+ * First pass over the filesystem. Keeps the appdb, and counts the app and
+ * resource files; there can't be more apps than that
+ */
+static bool _app_files_count(const char *name, const struct file *file, void *context)
+{
+    uint16_t *count = context;
+    uint32_t application_id;
+    
+    if (!_app_files_have_appdb && !strcmp(name, "appdb"))
+    {
+        _app_files_appdb = *file;
+        _app_files_have_appdb = true;
+        return true;
+    }
+    
+    if (_app_files_parse(name, &application_id))
+        (*count)++;
+    
+    return true;
+}
+
+/*
+ * Second pass. Keeps any app and resource files by their id
+ */
+static bool _app_files_add(const char *name, const struct file *file, void *context)
+{
+    app_files_index_t *files = context;
+    uint32_t application_id;
+    
+    uint8_t found = _app_files_parse(name, &application_id);
+    if (!found)
+        return true;
+    
+    app_files_t *node = _app_files_find(files, application_id);
+    if (node == NULL)
+    {
+        /* the fs can't have grown since we counted, but don't trust it */
+        if (files->used == files->size)
+            return false;
+        
+        node = &files->nodes[files->used++];
+        uint32_t bucket = application_id & files->mask;
+        node->application_id = application_id;
+        node->next = files->buckets[bucket];
+        files->buckets[bucket] = node;
+    }
+    
+    /* first one wins, as it would have for fs_find_file */
+    if (node->found & found)
+        return true;
+    
+    if (found == APP_FILES_APP)
+        node->app_file = *file;
+    else
+        node->res_file = *file;
+    node->found |= found;
+    
+    return true;
+}
+
+/*
+ * Find the appdb, and every app's files, in two passes over the
+ * filesystem instead of a search per app
+ */
+static bool _app_files_scan(app_files_index_t *files)
+{
+    uint16_t count = 0;
+    
+    memset(files, 0, sizeof(app_files_index_t));
+    
+    if (fs_for_each_file(_app_files_count, &count) < 0 || !_app_files_have_appdb)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "APPDB file not found");
+        return false;
+    }
+    
+    uint32_t buckets = _bucket_count(count);
+    files->buckets = calloc(1, buckets * sizeof(app_files_t *) + count * sizeof(app_files_t));
+    if (files->buckets == NULL)
+        return false;
+    
+    files->nodes = (app_files_t *)(files->buckets + buckets);
+    files->mask = buckets - 1;
+    files->size = count;
+    fs_for_each_file(_app_files_add, files);
+    
+    return true;
+}
+
+/*
+ * Size the manifest's hash tables for this many apps
+ */
+static void _appmanager_manifest_init(uint32_t apps)
+{
+    uint32_t buckets = _bucket_count(apps);
+    App **tables = calloc(2 * buckets, sizeof(App *));
+    
+    if (tables == NULL)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_WARNING, "No room to index %d apps", apps);
+        return;
+    }
+    
+    _app_by_name = tables;
+    _app_by_uuid = tables + buckets;
+    _app_bucket_mask = buckets - 1;
+}
 
 /*
  * Load any pre-existing apps into the manifest, search for any new ones and then start up
@@ -60,6 +294,11 @@ static App *_app_manifest_head;
 void appmanager_app_loader_init()
 {
     struct file empty = { 0, 0, 0 }; /* TODO: make files optional in `App` to avoid this */
+    app_files_index_t files;
+    
+    /* see what's on flash first, so the manifest can be sized for it */
+    bool have_files = _app_files_scan(&files);
+    _appmanager_manifest_init(APP_MANIFEST_BUILTIN + files.used);
     
     /* add the baked in apps */
     _appmanager_add_to_manifest(_appmanager_create_app("System", APP_TYPE_SYSTEM, systemapp_main, true, &empty, &empty));
@@ -70,7 +309,11 @@ void appmanager_app_loader_init()
     _appmanager_add_to_manifest(_appmanager_create_app("TestApp", APP_TYPE_SYSTEM, testapp_main, true, &empty, &empty));
     
     /* now load the ones on flash */
-    _appmanager_flash_load_app_manifest();
+    if (have_files)
+    {
+        _appmanager_flash_load_app_manifest(&files);
+        free(files.buckets);
+    }
 }
 
 
@@ -95,7 +338,6 @@ static App *_appmanager_create_app(char *name, uint8_t type, void *entry_point,
     app->main = (void*)entry_point;
     app->type = type;
     app->header = NULL;
-    app->next = NULL;
     app->app_file = *app_file;
     app->resource_file = *resource_file;
     app->is_internal = is_internal;
@@ -108,23 +350,13 @@ static App *_appmanager_create_app(char *name, uint8_t type, void *entry_point,
  * Load the list of apps and faces from flash
  * The app manifest is a list of all known applications we found in flash
  * We load all entries from `appdb` file.
- * TODO: appdb seems to have duplicates (in my case), maybe we should use `pmap`, but it was missing some entries for me
+ * appdb can have duplicates, so anything with a UUID we already have is skipped
  */
-static void _appmanager_flash_load_app_manifest(void)
+static void _appmanager_flash_load_app_manifest(app_files_index_t *files)
 {
-    struct file file;
-
-    if (fs_find_file(&file, "appdb") < 0)
-    {
-        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "APPDB file not found");
-        return;
-    }
-
-    char buffer[14];
+    struct file file = _app_files_appdb;
     struct appdb appdb;
     struct fd fd;
-    struct file app_file;
-    struct file res_file;
     struct fd app_fd;
     ApplicationHeader header;
 
@@ -155,15 +387,11 @@ static void _appmanager_flash_load_app_manifest(void)
             break;
         }
         
-        snprintf(buffer, 14, "@%08lx/app", appdb.application_id);
-        if (fs_find_file(&app_file, buffer) < 0)
+        app_files_t *app_files = _app_files_find(files, appdb.application_id);
+        if (app_files == NULL || app_files->found != (APP_FILES_APP | APP_FILES_RES))
             continue;
 
-        snprintf(buffer, 14, "@%08lx/res", appdb.application_id);
-        if (fs_find_file(&res_file, buffer) < 0)
-            continue;
-
-        fs_open(&app_fd, &app_file);
+        fs_open(&app_fd, &app_files->app_file);
 
         if (fs_read(&app_fd, &header, sizeof(ApplicationHeader)) != sizeof(ApplicationHeader))
             break;
@@ -180,37 +408,57 @@ static void _appmanager_flash_load_app_manifest(void)
             * TODO
             * crc32....(header.header)
             */
+        
+        /* appdb can hold the same app more than once */
+        if (appmanager_get_app_by_uuid(&header.uuid))
+        {
+            KERN_LOG("app", APP_LOG_LEVEL_DEBUG, "appdb: app \"%s\" is a duplicate", header.name);
+            continue;
+        }
+        
         KERN_LOG("app", APP_LOG_LEVEL_INFO, "appdb: app \"%s\" found, flags %08x, icon %08x", header.name, appdb.flags, appdb.icon);
 
         /* main gets set later */
-        _appmanager_add_to_manifest(_appmanager_create_app(header.name,
-                                                            APP_TYPE_FACE,
-                                                            NULL,
-                                                            false,
-                                                            &app_file,
-                                                            &res_file));
+        App *app = _appmanager_create_app(header.name,
+                                          APP_TYPE_FACE,
+                                          NULL,
+                                          false,
+                                          &app_files->app_file,
+                                          &app_files->res_file);
+        if (app)
+            memcpy(&app->uuid, &header.uuid, sizeof(Uuid));
+        _appmanager_add_to_manifest(app);
     }
 }
 
-/* 
- * App manifest is a linked list. Just slot it in 
+/*
+ * App manifest is a linked list. Slot it in at the end, and into the
+ * hash buckets
  */
 static void _appmanager_add_to_manifest(App *app)
 {  
-    if (_app_manifest_head == NULL)
-    {
-        _app_manifest_head = app;
+    if (app == NULL)
         return;
-    }
     
-    App *child = _app_manifest_head;
+    if (_app_manifest_tail)
+        _app_manifest_tail->next = app;
+    else
+        _app_manifest_head = app;
+    _app_manifest_tail = app;
+    
+    /* on the end of the chain, so the first app of a name is found first */
+    App **prev = &_app_by_name[_app_name_hash(app->name) & _app_bucket_mask];
+    while (*prev)
+        prev = &(*prev)->name_next;
+    *prev = app;
     
-    // now find the last node
-    while(child->next)
-        child = child->next;
+    /* the baked in apps don't have one */
+    if (_uuid_is_empty(&app->uuid))
+        return;
     
-    // link the node to the last child
-    child->next = app;
+    uint32_t bucket = _uuid_hash(&app->uuid) & _app_bucket_mask;
+    app->uuid_next = _app_by_uuid[bucket];
+    _app_by_uuid[bucket] = app;
 }
 
 /*
@@ -226,21 +474,30 @@ App *app_manager_get_apps_head()
  */
 App *appmanager_get_app(char *app_name)
 {
-    // find the app
-    App *node = _app_manifest_head;
+    uint32_t bucket = _app_name_hash(app_name) & _app_bucket_mask;
     
-    // now find the matching
-    while(node)
+    for (App *node = _app_by_name[bucket]; node; node = node->name_next)
     {
-        if (!strncmp(node->name, (char *)app_name, strlen(node->name)))
-        {
-            // match!
+        if (!strcmp(node->name, app_name))
             return node;
-        }
-
-        node = node->next;
     }
     
     KERN_LOG("app", APP_LOG_LEVEL_ERROR, "NO App Found %s", app_name);
     return NULL;
 }
+
+/*
+ * Get an application by its UUID. NULL if there's none
+ */
+App *appmanager_get_app_by_uuid(const Uuid *uuid)
+{
+    uint32_t bucket = _uuid_hash(uuid) & _app_bucket_mask;
+    
+    for (App *node = _app_by_uuid[bucket]; node; node = node->uuid_next)
+    {
+        if (!memcmp(&node->uuid, uuid, sizeof(Uuid)))
+            return node;
+    }
+    
+    return NULL;
+}
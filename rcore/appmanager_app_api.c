@@ -23,6 +23,21 @@ void appmanager_app_start(char *name)
     appmanager_post_generic_thread_message(&am, 100);
 }
 
+/*
+ * As appmanager_app_start, for an app we only know the UUID of.
+ * false if there's no such app
+ */
+bool appmanager_app_start_by_uuid(const Uuid *uuid)
+{
+    App *app = appmanager_get_app_by_uuid(uuid);
+    
+    if (app == NULL)
+        return false;
+    
+    appmanager_app_start(app->name);
+    return true;
+}
+
 void appmanager_app_quit(void)
 {
     AppMessage am = (AppMessage) {
@@ -32,13 +47,27 @@ void appmanager_app_quit(void)
     appmanager_post_generic_app_message(&am, 10);
 }
 
-void appmanager_post_button_message(ButtonMessage *bmessage)
+/*
+ * Have the manager kill an app thread that has wedged or gone wrong,
+ * and move on to whatever should run next
+ */
+void appmanager_app_crashed(AppThreadType thread_type)
+{
+    AppMessage am = (AppMessage) {
+        .message_type_id = THREAD_MANAGER_APP_CRASHED,
+        .thread_id = thread_type,
+        .payload = NULL
+    };
+    appmanager_post_generic_thread_message(&am, 100);
+}
+
+bool appmanager_post_button_message(ButtonMessage *bmessage)
 {
     AppMessage am = (AppMessage) {
         .message_type_id = APP_BUTTON,
         .payload = (void *)bmessage
     };
-    appmanager_post_generic_app_message(&am, 10);
+    return appmanager_post_generic_app_message(&am, 10);
 }
 
 void appmanager_post_draw_message(void)
@@ -10,6 +10,7 @@
 #include "appmanager.h"
 #include "overlay_manager.h"
 #include "notification_manager.h"
+#include "compositor.h"
 
 void back_long_click_handler(ClickRecognizerRef recognizer, void *context);
 void back_long_click_release_handler(ClickRecognizerRef recognizer, void *context);
@@ -18,18 +19,48 @@ void app_back_single_click_handler(ClickRecognizerRef recognizer, void *context)
 bool booted = false;
 
 static xQueueHandle _app_message_queue;
+static app_runloop_stats_t _runloop_stats;
+
+/* The most events handled before drawing, so that a steady stream of them
+ * can't keep the screen from ever updating */
+#define APP_EVENT_BATCH_MAX 10
 
 void appmanager_app_runloop_init(void)
 {
     _app_message_queue = xQueueCreate(5, sizeof(struct AppMessage));    
 }
 
+/* Let the watchdog know we are working on something, rather than
+ * waiting for something to do. Never 0, that means waiting */
+static void _runloop_busy(app_running_thread *thread)
+{
+    if (thread->busy_since == 0)
+        thread->busy_since = xTaskGetTickCount() | 1;
+}
+
+void appmanager_app_runloop_get_stats(app_runloop_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _runloop_stats;
+    taskEXIT_CRITICAL();
+}
+
+/*
+ * Clear the queue of any work from the previous app, such as an errant
+ * quit. The manager does this before starting the next one, so that a
+ * quit meant for the new app can't be lost
+ */
+void appmanager_app_runloop_reset(void)
+{
+    xQueueReset(_app_message_queue);
+}
+
 /* 
  * Send a message to an app 
  */
-void appmanager_post_generic_app_message(AppMessage *am, TickType_t timeout)
+bool appmanager_post_generic_app_message(AppMessage *am, TickType_t timeout)
 {
-    xQueueSendToBack(_app_message_queue, am, timeout);
+    return xQueueSendToBack(_app_message_queue, am, timeout);
 }
 
 /*
@@ -46,12 +77,15 @@ void appmanager_app_main_entry(void)
     /* Before we even see them, we have to reset fonts -- otherwise, the
      * font cache does some free business on old pointers, corrupting the
      * heap before we even had a fighting chance!  */
-    fonts_resetcache();
+    if (_this_thread->thread_type == AppThreadMainApp)
+        fonts_resetcache();
     
     /* Call into the apps main runtime */
     _this_thread->app->main();
     _this_thread->status = AppThreadUnloading;
     
+    app_memory_check_budget();
+    
     AppMessage am = {
         .thread_id = _this_thread->thread_type,
         .message_type_id = THREAD_MANAGER_APP_QUIT_CLEAN,
@@ -64,6 +98,26 @@ void appmanager_app_main_entry(void)
     vTaskDelay(portMAX_DELAY);
 }
 
+/*
+ * A worker's main() sits in here between its init and deinit. Workers
+ * don't get any events yet, so all there is to wait for is the manager
+ * asking us to quit
+ */
+void worker_event_loop(void)
+{
+    app_running_thread *_this_thread = appmanager_get_current_thread();
+    
+    if (_this_thread->thread_type != AppThreadWorker)
+    {
+        KERN_LOG("app", APP_LOG_LEVEL_ERROR, "Naughty! You tried to run a worker runloop!. You are not a worker");
+        return;
+    }
+    
+    KERN_LOG("app", APP_LOG_LEVEL_INFO, "Worker entered mainloop");
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    KERN_LOG("app", APP_LOG_LEVEL_INFO, "Worker Quit");
+}
+
 /*
  * Once an application is spawned, it calls into app_event_loop
  * This function is a busy loop, but with the benefit that it is also a task
@@ -103,10 +157,6 @@ void app_event_loop(void)
     }
     
     
-    /* clear the queue of any work from the previous app
-    * ... such as an errant quit */
-    xQueueReset(_app_message_queue);
-    
     if (!booted)
     {
         GRect frame = GRect(0, DISPLAY_ROWS - 20, DISPLAY_COLS, 20);
@@ -119,10 +169,19 @@ void app_event_loop(void)
     {
         /* Is there something queued up to do?  If so, we have the potential to do it. */
         TickType_t next_timer = appmanager_timer_get_next_expiry(_this_thread);
+        bool quit = false;
+        uint16_t events = 0;
         
-        /* we are inside the apps main loop event handler now */
-        if (xQueueReceive(_app_message_queue, &data, next_timer))
+        /* we are inside the apps main loop event handler now.
+         * Block for the first event, then take everything that queued up
+         * behind it, so that a burst of them is drawn just the once */
+        _this_thread->busy_since = 0;
+        while (events < APP_EVENT_BATCH_MAX &&
+               xQueueReceive(_app_message_queue, &data, events ? 0 : next_timer))
         {
+            events++;
+            _runloop_busy(_this_thread);
+            
             /* We woke up for some kind of event that someone posted.  But what? */
             if (data.message_type_id == APP_BUTTON)
             {
@@ -142,24 +201,45 @@ void app_event_loop(void)
                 /* remove the ticktimer service handler and stop it */
                 tick_timer_service_unsubscribe();
 
-                /* Set the shutdown time for this app. We will kill it then */
-                _this_thread->shutdown_at_tick = xTaskGetTickCount() + pdMS_TO_TICKS(5000);
-                
+                /* the manager gave us a deadline when it asked; if we
+                 * are still here after it, we get killed */
                 KERN_LOG("app", APP_LOG_LEVEL_INFO, "App Quit");
 
-                /* app was quit, break out of this loop into the main handler */
+                quit = true;
                 break;
             }
             else if (data.message_type_id == APP_DRAW)
             {
-                window_draw();
+                /* the overlays want repainting, whether or not they
+                 * marked a window to say so */
+                compositor_damage(CompositorOverlay);
             }
-        } else {
+        }
+        
+        /* app was quit, break out of this loop into the main handler */
+        if (quit)
+            break;
+        
+        /* then every timer that has come due meanwhile */
+        _runloop_busy(_this_thread);
+        while (events < APP_EVENT_BATCH_MAX && _this_thread->timer_head &&
+               appmanager_timer_get_next_expiry(_this_thread) == 0)
+        {
+            events++;
             appmanager_timer_expired(_this_thread);
         }
         
+        _runloop_stats.events += events;
+        
         /* Something changed, lets see if we can draw */
-        window_draw();
+        if (compositor_is_damaged())
+        {
+            window_draw();
+            _runloop_stats.frames++;
+        }
+        
+        /* and these events' scratch memory is done with */
+        app_frame_reset();
     }
     KERN_LOG("app", APP_LOG_LEVEL_INFO, "App Signalled shutdown...");
     /* We fall out of the apps main_ now and into deinit and thread completion
@@ -198,11 +278,11 @@ void appmanager_timer_expired(app_running_thread *thread)
          * happen only once before when the app draw was happening while the
          * ovelay thread was coming up. The ov thread memory was memset to 0. */
         KERN_LOG("app", APP_LOG_LEVEL_ERROR, "Bad Callback!");
-        thread->timer_head = timer->next;
+        appmanager_timer_remove(timer);
         return;
     }
 
-    thread->timer_head = timer->next;
+    appmanager_timer_remove(timer);
     
     timer->callback(timer);
 }
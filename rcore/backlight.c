@@ -17,7 +17,7 @@
 static TaskHandle_t _backlight_task;
 static StaticTask_t _backlight_task_buf;
 
-static StackType_t _backlight_task_stack[configMINIMAL_STACK_SIZE + 90];
+static StackType_t _backlight_task_stack[configMINIMAL_STACK_SIZE + 90] CCRAM_SYSTEM_STACK;
 static void _backlight_thread(void *pvParameters);
 
 typedef struct backlight_message
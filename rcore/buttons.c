@@ -21,11 +21,11 @@
 
 static TaskHandle_t _button_debounce_task;
 static StaticTask_t _button_debounce_task_buf;
-static StackType_t _button_debounce_task_stack[configMINIMAL_STACK_SIZE + 130];
+static StackType_t _button_debounce_task_stack[configMINIMAL_STACK_SIZE + 130] CCRAM_SYSTEM_STACK;
 
 static TaskHandle_t _button_message_task;
 static StaticTask_t _button_message_task_buf;
-static StackType_t _button_message_task_stack[configMINIMAL_STACK_SIZE + 160];
+static StackType_t _button_message_task_stack[configMINIMAL_STACK_SIZE + 160] CCRAM_SYSTEM_STACK;
 
 static xQueueHandle _button_queue;
 static StaticQueue_t _button_queue_buf;
@@ -53,8 +53,8 @@ void rcore_buttons_init(void)
 {
     hw_button_init();
     
-    _button_message_task = xTaskCreateStatic(_button_message_thread, "Button", configMINIMAL_STACK_SIZE + 160, NULL, tskIDLE_PRIORITY + 5UL, _button_message_task_stack, &_button_message_task_buf);
-    _button_debounce_task = xTaskCreateStatic(_button_debounce_thread, "Debounce", configMINIMAL_STACK_SIZE + 130, NULL, tskIDLE_PRIORITY + 5UL, _button_debounce_task_stack, &_button_debounce_task_buf);
+    _button_message_task = xTaskCreateStatic(_button_message_thread, "Button", configMINIMAL_STACK_SIZE + 160, NULL, tskIDLE_PRIORITY + 4UL, _button_message_task_stack, &_button_message_task_buf);
+    _button_debounce_task = xTaskCreateStatic(_button_debounce_thread, "Debounce", configMINIMAL_STACK_SIZE + 130, NULL, tskIDLE_PRIORITY + 4UL, _button_debounce_task_stack, &_button_debounce_task_buf);
     
     _button_queue = xQueueCreateStatic(5, sizeof(uint8_t), _button_queue_contents, &_button_queue_buf);
     
@@ -0,0 +1,98 @@
+/* compositor.c
+ * Puts the app's window and any overlays over it into the framebuffer,
+ * redrawing only the sources that changed, and pushes the frame out
+ * RebbleOS
+ */
+
+#include "rebbleos.h"
+#include "compositor.h"
+#include "overlay_manager.h"
+#include "librebble.h"
+
+/* How long we give the overlay thread to take a draw request */
+#define COMPOSITOR_OVERLAY_POST_MS 100
+
+/* Damage reported directly, on top of windows marked for render */
+static uint8_t _damage;
+static compositor_stats_t _stats;
+
+/*
+ * Note that a source needs drawing, without there being a window to mark.
+ * Such as an overlay animation stepping on
+ */
+void compositor_damage(CompositorSource source)
+{
+    taskENTER_CRITICAL();
+    _damage |= source;
+    taskEXIT_CRITICAL();
+}
+
+bool compositor_is_damaged(void)
+{
+    return _damage || window_is_dirty();
+}
+
+void compositor_get_stats(compositor_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _stats;
+    taskEXIT_CRITICAL();
+}
+
+/*
+ * Called from the app thread to compose and push out a frame.
+ *
+ * We only hold the one framebuffer, so what a source drew last is kept
+ * there rather than in a buffer of its own. A redrawn app window paints
+ * over any overlays, so they have to be drawn again on top of it. An
+ * overlay that changed on its own can be drawn straight over the app's
+ * last render. Overlays that move or go away mark the app window for
+ * render, to clean up under them.
+ *
+ * Overlay windows were built in the overlay thread's heap, so that thread
+ * draws them. If there are none, which is most of the time, the frame
+ * never leaves this thread
+ */
+void compositor_frame(void)
+{
+    /* Make sure noone else can draw while we are drawing. If someone has
+     * held on for this long, draw anyway rather than lose the frame */
+    bool locked = display_buffer_lock_take(500);
+    if (!locked)
+        KERN_LOG("compositor", APP_LOG_LEVEL_ERROR, "Framebuffer lock timed out");
+    
+    taskENTER_CRITICAL();
+    uint8_t damage = _damage;
+    _damage = 0;
+    taskEXIT_CRITICAL();
+    
+    Window *wind = window_stack_get_top_window();
+    bool app = (damage & CompositorApp) || (wind && wind->is_render_scheduled);
+    bool overlay = overlay_window_count() &&
+                   (app || (damage & CompositorOverlay) || overlay_window_is_dirty());
+    
+    if (app && wind)
+    {
+        rbl_window_draw(wind);
+        _stats.app_draws++;
+    }
+    
+    if (wind)
+        wind->is_render_scheduled = false;
+    
+    /* Now sit and wait for the overlay thread to signal done */
+    if (overlay && overlay_window_draw(pdMS_TO_TICKS(COMPOSITOR_OVERLAY_POST_MS)))
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        _stats.overlay_draws++;
+    }
+    
+    if (app || overlay)
+    {
+        rbl_draw();
+        _stats.frames++;
+    }
+    
+    if (locked)
+        display_buffer_lock_give();
+}
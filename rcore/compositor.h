@@ -0,0 +1,27 @@
+#pragma once
+/* compositor.h
+ * Puts the app's window and any overlays over it into the framebuffer,
+ * redrawing only the sources that changed, and pushes the frame out
+ * RebbleOS
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Notifications are overlays too, so come under CompositorOverlay */
+typedef enum CompositorSource {
+    CompositorApp     = 1 << 0,
+    CompositorOverlay = 1 << 1,
+} CompositorSource;
+
+/* What the compositor has done, since boot */
+typedef struct compositor_stats_t {
+    uint32_t frames;        /* pushed out to the display */
+    uint32_t app_draws;
+    uint32_t overlay_draws; /* passes over to the overlay thread */
+} compositor_stats_t;
+
+void compositor_damage(CompositorSource source);
+bool compositor_is_damaged(void);
+void compositor_frame(void);
+void compositor_get_stats(compositor_stats_t *stats);
@@ -6,12 +6,13 @@
  */
 
 #include <stdio.h>
+#include "rebbleos.h"
 #include "debug.h"
 #include "platform.h"
 
 #define PANIC_STACK_SIZE (224 / 2)
 
-static StackType_t _panic_stack[PANIC_STACK_SIZE] CCRAM;
+static StackType_t _panic_stack[PANIC_STACK_SIZE] CCRAM_BSS;
 
 __attribute__((__noreturn__)) static void _panic(const char *s) {
     portDISABLE_INTERRUPTS();
@@ -32,3 +33,158 @@ __attribute__((__noreturn__)) static void _panic(const char *s) {
         [s]"r" (s) );
     __builtin_unreachable();
 }
+
+/* Run time stats clock. Microseconds rather than raw cycles, so that the
+ * 32 bit totals FreeRTOS keeps last over an hour before they wrap */
+static uint32_t _runtime_us;
+/* CYCCNT as of _runtime_us; the cycles since are carried to the next read */
+static uint32_t _runtime_cycles;
+
+void debug_runtime_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    _runtime_cycles = 0;
+    _runtime_us = 0;
+}
+
+/* CYCCNT wraps every 40s or so at 100MHz; the tick hook, and the end of
+ * every tickless sleep, have us back here well before that */
+static void _runtime_catch_up(void)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t us = (DWT->CYCCNT - _runtime_cycles) / cycles_per_us;
+    
+    _runtime_us += us;
+    _runtime_cycles += us * cycles_per_us;
+}
+
+/* Called on every context switch, as well as from tasks */
+uint32_t debug_runtime_counter(void)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    _runtime_catch_up();
+    uint32_t us = _runtime_us;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    
+    return us;
+}
+
+/*
+ * The cycle counter stops along with the core clock, so tickless idle
+ * tells us how long it was really out for since it read from. The idle
+ * task is the one that gets the credit
+ */
+void debug_runtime_slept(uint32_t from, uint32_t us)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    _runtime_catch_up();
+    uint32_t counted = _runtime_us - from;
+    if (us > counted)
+        _runtime_us += us - counted;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/* Where every task was at the last task_cpu_log, so it can log the
+ * share of the time since rather than since boot */
+#define TASK_CPU_SAMPLES 16
+
+typedef struct task_cpu_sample {
+    UBaseType_t number;
+    uint32_t runtime;
+    uint32_t switches;
+} task_cpu_sample;
+
+static task_cpu_sample _task_cpu_samples[TASK_CPU_SAMPLES];
+static uint8_t _task_cpu_sample_count;
+static uint32_t _task_cpu_total;
+
+static task_cpu_sample *_task_cpu_sample_find(UBaseType_t number)
+{
+    for (uint8_t i = 0; i < _task_cpu_sample_count; i++)
+        if (_task_cpu_samples[i].number == number)
+            return &_task_cpu_samples[i];
+    
+    return NULL;
+}
+
+/*
+ * Each task's share of the CPU and how often it was switched in since we
+ * were last called (or since it started), and its stack headroom
+ */
+void task_cpu_log(void)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = pvPortMalloc(count * sizeof(TaskStatus_t));
+    if (tasks == NULL)
+    {
+        KERN_LOG("debug", APP_LOG_LEVEL_ERROR, "No memory for the task list");
+        return;
+    }
+    
+    uint32_t total;
+    count = uxTaskGetSystemState(tasks, count, &total);
+    uint32_t elapsed = total - _task_cpu_total;
+    if (elapsed == 0)
+        elapsed = 1;
+    
+    KERN_LOG("debug", APP_LOG_LEVEL_INFO, "CPU over the last %dms:", elapsed / 1000);
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        TaskStatus_t *task = &tasks[i];
+        uint32_t switches = (uint32_t)pvTaskGetThreadLocalStoragePointer(task->xHandle, DEBUG_TLS_SWITCHES);
+        uint32_t runtime = task->ulRunTimeCounter;
+        
+        task_cpu_sample *last = _task_cpu_sample_find(task->xTaskNumber);
+        if (last)
+        {
+            runtime -= last->runtime;
+            switches -= last->switches;
+        }
+        
+        uint32_t permille = (uint64_t)runtime * 1000 / elapsed;
+        KERN_LOG("debug", APP_LOG_LEVEL_INFO, "  %s: %d.%d%%, %d switches, %d stack words free",
+                 task->pcTaskName, permille / 10, permille % 10, switches,
+                 task->usStackHighWaterMark);
+    }
+    
+    /* tasks that have gone since last time drop out here */
+    _task_cpu_sample_count = count < TASK_CPU_SAMPLES ? count : TASK_CPU_SAMPLES;
+    for (uint8_t i = 0; i < _task_cpu_sample_count; i++)
+    {
+        _task_cpu_samples[i].number = tasks[i].xTaskNumber;
+        _task_cpu_samples[i].runtime = tasks[i].ulRunTimeCounter;
+        _task_cpu_samples[i].switches = (uint32_t)pvTaskGetThreadLocalStoragePointer(tasks[i].xHandle, DEBUG_TLS_SWITCHES);
+    }
+    _task_cpu_total = total;
+    
+    vPortFree(tasks);
+}
+
+#ifdef TASK_CPU_LOG_MS
+/* Debug builds can build with -DTASK_CPU_LOG_MS=<period> to have the
+ * above logged all the time, from a task of its own at the lowest
+ * priority so that logging never holds anything else up */
+#define TASK_CPU_LOG_STACK_SIZE (configMINIMAL_STACK_SIZE + 160)
+
+static StackType_t _task_cpu_log_stack[TASK_CPU_LOG_STACK_SIZE];
+static StaticTask_t _task_cpu_log_task;
+
+static void _task_cpu_log_thread(void *pvParameters)
+{
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(TASK_CPU_LOG_MS));
+        task_cpu_log();
+    }
+}
+#endif
+
+void debug_init_late(void)
+{
+#ifdef TASK_CPU_LOG_MS
+    xTaskCreateStatic(_task_cpu_log_thread, "CpuLog", TASK_CPU_LOG_STACK_SIZE, NULL,
+                      tskIDLE_PRIORITY + 1UL, _task_cpu_log_stack, &_task_cpu_log_task);
+#endif
+}
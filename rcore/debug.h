@@ -1,6 +1,8 @@
 #ifndef __DEBUG_H
 #define __DEBUG_H
 
+#include <stdint.h>
+
 #define __S(x) #x
 #define __S_(x) __S(x)
 #define S__LINE__ __S_(__LINE__)
@@ -9,4 +11,10 @@
 
 void panic(const char *s);
 
+void debug_runtime_init(void);
+uint32_t debug_runtime_counter(void);
+void debug_runtime_slept(uint32_t from, uint32_t us);
+void task_cpu_log(void);
+void debug_init_late(void);
+
 #endif
@@ -0,0 +1,142 @@
+/* deferred.c
+ * Work queued by interrupt handlers, run by a worker task
+ * RebbleOS
+ */
+
+#include "rebbleos.h"
+#include "deferred.h"
+
+#define DEFERRED_STACK_SIZE (configMINIMAL_STACK_SIZE + 100)
+/* The top priority, which nothing else uses, so handed off work never
+ * waits behind an app */
+#define DEFERRED_PRIORITY (configMAX_PRIORITIES - 1)
+
+/*
+ * Every slot carries a sequence number saying whose turn it is. A slot at
+ * ring position pos is free to claim when its sequence is pos, and has
+ * work in it when it is pos + 1. After running it, the worker moves it on
+ * to pos + DEFERRED_QUEUE_SIZE, ready for the next lap.
+ * Handlers can interrupt each other, so they claim slots by compare and
+ * swap on the head rather than masking interrupts. Only the worker moves
+ * the tail
+ */
+typedef struct deferred_slot_t {
+    uint32_t seq;
+    deferred_func_t func;
+    void *arg;
+    uint32_t value;
+} deferred_slot_t;
+
+static deferred_slot_t _deferred_ring[DEFERRED_QUEUE_SIZE];
+static uint32_t _deferred_head;
+static uint32_t _deferred_tail;
+static deferred_stats_t _deferred_stats;
+
+static TaskHandle_t _deferred_task;
+/* SRAM; CCRAM has no room left for it on snowy */
+static StackType_t _deferred_stack[DEFERRED_STACK_SIZE];
+static StaticTask_t _deferred_task_buf;
+
+static void _deferred_thread(void *pvParameters);
+
+void deferred_init(void)
+{
+    for (uint32_t i = 0; i < DEFERRED_QUEUE_SIZE; i++)
+        _deferred_ring[i].seq = i;
+    
+    _deferred_task = xTaskCreateStatic(_deferred_thread, "Deferred", DEFERRED_STACK_SIZE, NULL,
+                                       DEFERRED_PRIORITY, _deferred_stack, &_deferred_task_buf);
+}
+
+/*
+ * Queue func(arg, value) to run on the worker. Safe from any interrupt
+ * that may use the FreeRTOS FromISR calls. false if the ring is full, in
+ * which case the work is not done
+ */
+bool deferred_call_from_isr(deferred_func_t func, void *arg, uint32_t value)
+{
+    deferred_slot_t *slot;
+    uint32_t pos = __atomic_load_n(&_deferred_head, __ATOMIC_RELAXED);
+    
+    for (;;)
+    {
+        slot = &_deferred_ring[pos & (DEFERRED_QUEUE_SIZE - 1)];
+        int32_t turn = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        
+        if (turn == 0)
+        {
+            /* ours, unless someone got in first; then pos is theirs + 1 */
+            if (__atomic_compare_exchange_n(&_deferred_head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (turn < 0)
+        {
+            /* the worker hasn't got round to this slot's last lap */
+            __atomic_fetch_add(&_deferred_stats.dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&_deferred_head, __ATOMIC_RELAXED);
+        }
+    }
+    
+    slot->func = func;
+    slot->arg = arg;
+    slot->value = value;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    
+    __atomic_fetch_add(&_deferred_stats.queued, 1, __ATOMIC_RELAXED);
+    /* other handlers may be raising it too; only ever move it up */
+    uint32_t used = pos + 1 - __atomic_load_n(&_deferred_tail, __ATOMIC_RELAXED);
+    uint32_t high = __atomic_load_n(&_deferred_stats.high_water, __ATOMIC_RELAXED);
+    while (used > high &&
+           !__atomic_compare_exchange_n(&_deferred_stats.high_water, &high, used, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+    
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(_deferred_task, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    
+    return true;
+}
+
+void deferred_get_stats(deferred_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _deferred_stats;
+    taskEXIT_CRITICAL();
+}
+
+/*
+ * Run everything queued, in order. A slot claimed but not yet filled
+ * (its handler was interrupted by another) stops us; that handler
+ * notifies us again once it has filled it
+ */
+static void _deferred_thread(void *pvParameters)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        for (;;)
+        {
+            deferred_slot_t *slot = &_deferred_ring[_deferred_tail & (DEFERRED_QUEUE_SIZE - 1)];
+            
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != _deferred_tail + 1)
+                break;
+            
+            deferred_func_t func = slot->func;
+            void *arg = slot->arg;
+            uint32_t value = slot->value;
+            
+            /* free the slot before running, so the work can queue more */
+            __atomic_store_n(&slot->seq, _deferred_tail + DEFERRED_QUEUE_SIZE, __ATOMIC_RELEASE);
+            __atomic_store_n(&_deferred_tail, _deferred_tail + 1, __ATOMIC_RELAXED);
+            
+            func(arg, value);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+/* deferred.h
+ * Hand work from an interrupt handler to a task. The handler queues a
+ * function and its arguments and returns; a high priority worker calls
+ * it soon after, with interrupts on and all of the RTOS to hand
+ * RebbleOS
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Slots in the ring; a power of two */
+#ifndef DEFERRED_QUEUE_SIZE
+#define DEFERRED_QUEUE_SIZE 16
+#endif
+
+typedef void (*deferred_func_t)(void *arg, uint32_t value);
+
+/* How much the queue has been used, since boot */
+typedef struct deferred_stats_t {
+    uint32_t queued;
+    uint32_t dropped;       /* the ring was full */
+    uint32_t high_water;    /* most slots in use at once */
+} deferred_stats_t;
+
+void deferred_init(void);
+bool deferred_call_from_isr(deferred_func_t func, void *arg, uint32_t value);
+void deferred_get_stats(deferred_stats_t *stats);
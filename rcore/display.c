@@ -16,9 +16,12 @@ static void _display_thread(void *pvParameters);
 static void _display_start_frame(uint8_t offset_x, uint8_t offset_y);
 static void _display_cmd(uint8_t cmd, char *data);
 
-/* A mutex to use for locking buffers */
+/* Locks the framebuffer while a frame is drawn. A binary semaphore and
+ * not a mutex, so that if the holder is killed someone else can give it
+ * back for it */
 static StaticSemaphore_t _draw_mutex_mem;
 static SemaphoreHandle_t _draw_mutex;
+static TaskHandle_t _draw_mutex_holder;
 
 
 /*
@@ -33,7 +36,8 @@ void display_init(void)
     
     _display_queue = xQueueCreate(2, sizeof(uint8_t));
     _display_mutex = xSemaphoreCreateMutexStatic(&_display_mutex_buf);
-    _draw_mutex    = xSemaphoreCreateMutexStatic(&_draw_mutex_mem);
+    _draw_mutex    = xSemaphoreCreateBinaryStatic(&_draw_mutex_mem);
+    xSemaphoreGive(_draw_mutex);
     
     _display_cmd(DISPLAY_CMD_DRAW, NULL);
     
@@ -153,10 +157,31 @@ inline bool display_buffer_lock_take(uint16_t timeout)
     xSemaphoreGive(_display_mutex);
     
     /* Now we can give the mutex out */
-    return xSemaphoreTake(_draw_mutex, (TickType_t)timeout);
+    if (!xSemaphoreTake(_draw_mutex, (TickType_t)timeout))
+        return false;
+    
+    _draw_mutex_holder = xTaskGetCurrentTaskHandle();
+    return true;
 }
 
 inline bool display_buffer_lock_give(void)
 {
+    _draw_mutex_holder = NULL;
     return xSemaphoreGive(_draw_mutex);
 }
+
+/*
+ * The task has been killed. If it had the framebuffer locked, unlock it,
+ * or every frame after would wait out the lock timeout
+ */
+void display_buffer_lock_release_task(TaskHandle_t task)
+{
+    taskENTER_CRITICAL();
+    bool held = task != NULL && _draw_mutex_holder == task;
+    if (held)
+        _draw_mutex_holder = NULL;
+    taskEXIT_CRITICAL();
+    
+    if (held)
+        xSemaphoreGive(_draw_mutex);
+}
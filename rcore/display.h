@@ -7,6 +7,7 @@
  */
 
 #include "FreeRTOS.h"
+#include "task.h"
 #include <stdbool.h>
 
 #define DISPLAY_MODE_BOOTLOADER      0
@@ -34,3 +35,4 @@ uint8_t *display_get_buffer(void);
 
 bool display_buffer_lock_give(void);
 bool display_buffer_lock_take(uint16_t timeout);
+void display_buffer_lock_release_task(TaskHandle_t task);
@@ -243,6 +243,38 @@ int fs_find_file(struct file *file, const char *name)
     return -1;
 }
 
+/*
+ * Hand every live file to the callback, in page order, reading each header
+ * just the once. Stops early if the callback returns false
+ */
+int fs_for_each_file(fs_file_callback callback, void *context)
+{
+    if (!_fs_valid)
+        return -1;
+
+    struct file_hdr_with_name buffer;
+    struct file_hdr *hdr = &buffer.hdr;
+    struct file file;
+    int count = 0;
+
+    for (uint16_t pg = 0; pg < REGION_FS_N_PAGES; pg++)
+    {
+        if (_fs_get_page_state(pg) != PageStateFileStart)
+            continue;
+
+        _fs_read_file_hdr(pg, &buffer);
+        file.startpage = pg;
+        file.size = hdr->file_size;
+        file.startpofs = sizeof(struct file_hdr) + hdr->filename_len;
+        count++;
+
+        if (!callback(buffer.name, &file, context))
+            break;
+    }
+
+    return count;
+}
+
 void fs_open(struct fd *fd, const struct file *file)
 {
     fd->file = *file;
@@ -6,6 +6,7 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 struct file {
     uint16_t startpage;
@@ -29,8 +30,11 @@ enum seek {
     FS_SEEK_END
 };
 
+typedef bool (*fs_file_callback)(const char *name, const struct file *file, void *context);
+
 void fs_init();
 int fs_find_file(struct file *file, const char *name);
+int fs_for_each_file(fs_file_callback callback, void *context);
 void fs_open(struct fd *fd, const struct file *file);
 int fs_read(struct fd *fd, void *p, size_t n);
 long fs_seek(struct fd *fd, long ofs, enum seek whence);
@@ -8,6 +8,7 @@
 #include "rebbleos.h"
 #include "watchdog.h"
 #include "ambient.h"
+#include "deferred.h"
 
 extern const char git_version[];
 
@@ -37,6 +38,8 @@ void hardware_init(void)
     KERN_LOG("init", APP_LOG_LEVEL_INFO, "Debug Init");
     rcore_watchdog_init_early();
     KERN_LOG("init", APP_LOG_LEVEL_INFO, "Watchdog Init");
+    deferred_init();
+    KERN_LOG("init", APP_LOG_LEVEL_INFO, "Deferred Init");
     bluetooth_init();
     KERN_LOG("init", APP_LOG_LEVEL_INFO, "Bluetooth Init");
     power_init();
@@ -59,6 +62,7 @@ void hardware_init(void)
     platform_init_late();
     rcore_watchdog_init_late();
     KERN_LOG("init", APP_LOG_LEVEL_INFO, "watchdog is ticking");
+    debug_init_late();
 }
 
 /*
@@ -66,6 +70,9 @@ void hardware_init(void)
  */
 
 void vApplicationTickHook(void) {
+    /* keeps the run time stats clock from missing a cycle counter wrap
+     * when one task runs for a long time without a switch */
+    debug_runtime_counter();
 }
 
 /* vApplicationMallocFailedHook() will only be called if
@@ -122,7 +129,7 @@ used by the Idle task. */
  * Ginge
  * 
  */
-static StackType_t _idle_stack[250];
+static StackType_t _idle_stack[250] CCRAM_SYSTEM_STACK;
 static StaticTask_t _idle_tcb;
 void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize) {
     *ppxIdleTaskTCBBuffer = &_idle_tcb;
@@ -11,6 +11,13 @@
 #include "overlay_manager.h"
 #include "platform_res.h"
 #include "notification_message.h"
+void notification_release(notification_data *data)
+{
+    if (data->timer)
+        app_timer_cancel(data->timer);
+    data->timer = NULL;
+    noty_free(data);
+}
 
 static void _notif_timeout_cb(void *data);
 static void _notif_init(OverlayWindow *overlay_window);
@@ -82,3 +82,12 @@ typedef struct notification_mini_msg_t {
     uint16_t icon;
     GRect frame;
 } notification_mini_msg;
+
+/**
+ * @brief Free a notification's context once its window is going away
+ * 
+ * Call from the window's unload handler, on the overlay thread. Cancels
+ * the timeout if it is still pending, as the timer lives on that thread.
+ * @param data the \ref notification_data at the start of the context
+ */
+void notification_release(notification_data *data);
@@ -8,6 +8,7 @@
 #include "protocol_notification.h"
 #include "notification_manager.h"
 #include "notification_message.h"
+#include "qslab.h"
 
 /*
  * A little message handler
@@ -18,16 +19,44 @@
  */
 #define MSG_HEAP_SIZE 10000
 
-static uint8_t _notification_messages_heap[MSG_HEAP_SIZE] CCRAM;
+/* Objects per slab page. A typical notification has a couple of
+ * actions and up to four attributes */
+#define MSG_SLAB_PAGE_MSGS 4
+#define MSG_SLAB_PAGE_PARTS 8
+
+/* Messages kept for the notification list. Past this, or when the heap
+ * can't fit a new one, the oldest are freed to make room */
+#define MSG_MAX_STORED 16
+
+static uint8_t _notification_messages_heap[MSG_HEAP_SIZE] CCRAM_BSS;
 static qarena_t *_notification_arena;
+/* Unlike the app heaps, this one is shared. Messages are built on the
+ * bluetooth thread and freed from the overlay thread */
+static SemaphoreHandle_t _notification_arena_mutex;
+static StaticSemaphore_t _notification_arena_mutex_buf;
+
+/* The fixed size parts of every message come from slabs, so only the
+ * variable length strings go to the arena on their own */
+static qslab_t _msg_slab;
+static qslab_t _header_slab;
+static qslab_t _attribute_slab;
+static qslab_t _action_slab;
 static list_head _messages_head = LIST_HEAD(_messages_head);
 
-static full_msg_t *_fake_message(char *text, char *action);
+static full_msg_t *_fake_message(const char *text, const char *action);
+static uint8_t *_message_strdup(const char *str);
+static bool _message_evict_oldest(void);
+static void *_slab_calloc(qslab_t *slab, size_t size);
 
 
 void messages_init(void)
 {
+    _notification_arena_mutex = xSemaphoreCreateMutexStatic(&_notification_arena_mutex_buf);
     _notification_arena = qinit(_notification_messages_heap, MSG_HEAP_SIZE);
+    qslab_init(&_msg_slab, _notification_arena, sizeof(full_msg_t), MSG_SLAB_PAGE_MSGS);
+    qslab_init(&_header_slab, _notification_arena, sizeof(cmd_phone_notify_t), MSG_SLAB_PAGE_MSGS);
+    qslab_init(&_attribute_slab, _notification_arena, sizeof(cmd_phone_attribute_t), MSG_SLAB_PAGE_PARTS);
+    qslab_init(&_action_slab, _notification_arena, sizeof(cmd_phone_action_t), MSG_SLAB_PAGE_PARTS);
 
     /* create three samples */
 //     message_add(_fake_message("RebbleOS is here!", "To Moon"));
@@ -35,20 +64,17 @@ void messages_init(void)
 //     message_add(_fake_message("Missed Call: Bob", "Dismiss"));
 }
 
-static full_msg_t *_fake_message(char *text, char *action)
+static full_msg_t *_fake_message(const char *text, const char *action)
 {
-    full_msg_t *m = noty_calloc(1, sizeof(full_msg_t));
-    cmd_phone_notify_t *n = noty_calloc(1, sizeof(cmd_phone_notify_t));
-    m->header = n;
+    full_msg_t *m = message_create();
     m->header->attr_count = 1;
     m->header->action_count = 1;
     
-    cmd_phone_attribute_t *new_attr = noty_calloc(1, sizeof(cmd_phone_attribute_t));
-    cmd_phone_action_t *new_act = noty_calloc(1, sizeof(cmd_phone_action_t));
-    new_attr->data = (uint8_t *)text;
-    new_act->data = (uint8_t *)action;
-    list_init_head(&m->attributes_list_head);
-    list_init_head(&m->actions_list_head);
+    cmd_phone_attribute_t *new_attr = message_attribute_create();
+    cmd_phone_action_t *new_act = message_action_create();
+    /* message_destroy frees these, so they have to live on our heap */
+    new_attr->data = _message_strdup(text);
+    new_act->data = _message_strdup(action);
     list_init_node(&new_act->node);
     list_init_node(&new_attr->node);
     list_insert_tail(&m->attributes_list_head, &new_attr->node);
@@ -63,6 +89,39 @@ void message_add(full_msg_t *msg)
      * it should already be allocated on our heap */
     list_init_node(&msg->node);
     list_insert_head(&_messages_head, &msg->node);
+    
+    while (message_count() > MSG_MAX_STORED && _message_evict_oldest())
+        ;
+}
+
+void message_remove(full_msg_t *msg)
+{
+    list_remove(&_messages_head, &msg->node);
+    message_destroy(msg);
+}
+
+/* Drop the oldest message, but never the newest; that one may be on
+ * screen. false if there is nothing we can free */
+static bool _message_evict_oldest(void)
+{
+    list_node *oldest = list_get_tail(&_messages_head);
+    
+    if (oldest == NULL || oldest == list_get_head(&_messages_head))
+        return false;
+    
+    SYS_LOG("NOTY", APP_LOG_LEVEL_INFO, "Message store full, dropping the oldest");
+    message_remove(list_elem(oldest, full_msg_t, node));
+    return true;
+}
+
+static uint8_t *_message_strdup(const char *str)
+{
+    size_t len = strlen(str) + 1;
+    uint8_t *x = noty_calloc(1, len);
+    
+    if (x != NULL)
+        memcpy(x, str, len);
+    return x;
 }
 
 list_head *message_get_head(void)
@@ -85,8 +144,15 @@ uint16_t message_count(void)
 
 void *noty_calloc(size_t count, size_t size)
 {
+    void *x;
+    
     /* uses a special qarena */
-    void *x = qalloc(_notification_arena, count * size);
+    do {
+        xSemaphoreTake(_notification_arena_mutex, portMAX_DELAY);
+        x = qalloc(_notification_arena, count * size);
+        xSemaphoreGive(_notification_arena_mutex);
+    } while (x == NULL && _message_evict_oldest());
+    
     if (x != NULL)
         memset(x, 0, count * size);
     return x;
@@ -94,6 +160,93 @@ void *noty_calloc(size_t count, size_t size)
 
 void noty_free(void *mem)
 {
+    xSemaphoreTake(_notification_arena_mutex, portMAX_DELAY);
     qfree(_notification_arena, mem);
+    xSemaphoreGive(_notification_arena_mutex);
+}
+
+qarena_t *messages_get_arena(void)
+{
+    return _notification_arena;
+}
+
+static void *_slab_calloc(qslab_t *slab, size_t size)
+{
+    void *x;
+    
+    do {
+        xSemaphoreTake(_notification_arena_mutex, portMAX_DELAY);
+        x = qslab_alloc(slab);
+        xSemaphoreGive(_notification_arena_mutex);
+    } while (x == NULL && _message_evict_oldest());
+    
+    if (x != NULL)
+        memset(x, 0, size);
+    return x;
+}
+
+full_msg_t *message_create(void)
+{
+    full_msg_t *msg = _slab_calloc(&_msg_slab, sizeof(full_msg_t));
+    if (msg == NULL)
+        return NULL;
+
+    msg->header = _slab_calloc(&_header_slab, sizeof(cmd_phone_notify_t));
+    if (msg->header == NULL)
+    {
+        xSemaphoreTake(_notification_arena_mutex, portMAX_DELAY);
+        qslab_free(&_msg_slab, msg);
+        xSemaphoreGive(_notification_arena_mutex);
+        return NULL;
+    }
+
+    list_init_head(&msg->attributes_list_head);
+    list_init_head(&msg->actions_list_head);
+    return msg;
+}
+
+cmd_phone_attribute_t *message_attribute_create(void)
+{
+    return _slab_calloc(&_attribute_slab, sizeof(cmd_phone_attribute_t));
+}
+
+cmd_phone_action_t *message_action_create(void)
+{
+    return _slab_calloc(&_action_slab, sizeof(cmd_phone_action_t));
+}
+
+/*
+ * Free a message and everything hanging off it in one go.
+ * The strings are expected to be on the message heap (noty_calloc)
+ */
+void message_destroy(full_msg_t *msg)
+{
+    list_node *l;
+
+    if (msg == NULL)
+        return;
+
+    xSemaphoreTake(_notification_arena_mutex, portMAX_DELAY);
+
+    while ((l = list_get_head(&msg->attributes_list_head)))
+    {
+        cmd_phone_attribute_t *attr = list_elem(l, cmd_phone_attribute_t, node);
+        list_remove(&msg->attributes_list_head, l);
+        qfree(_notification_arena, attr->data);
+        qslab_free(&_attribute_slab, attr);
+    }
+
+    while ((l = list_get_head(&msg->actions_list_head)))
+    {
+        cmd_phone_action_t *act = list_elem(l, cmd_phone_action_t, node);
+        list_remove(&msg->actions_list_head, l);
+        qfree(_notification_arena, act->data);
+        qslab_free(&_action_slab, act);
+    }
+
+    qslab_free(&_header_slab, msg->header);
+    qslab_free(&_msg_slab, msg);
+
+    xSemaphoreGive(_notification_arena_mutex);
 }
 
@@ -27,6 +27,47 @@ void *noty_calloc(size_t count, size_t size);
  */
 void noty_free(void *mem);
 
+/**
+ * @brief Get the message heap arena, for heap statistics
+ * 
+ * @return the arena, or NULL before \ref messages_init
+ */
+qarena_t *messages_get_arena(void);
+
+/**
+ * @brief Create an empty message, with its header, on the message heap
+ * 
+ * Messages and their attributes and actions come from fixed size slabs,
+ * so creating and destroying them doesn't fragment the message heap.
+ * @return the message, or NULL if the heap is full
+ */
+full_msg_t *message_create(void);
+
+/**
+ * @brief Create an attribute to add to a message's attribute list
+ */
+cmd_phone_attribute_t *message_attribute_create(void);
+
+/**
+ * @brief Create an action to add to a message's action list
+ */
+cmd_phone_action_t *message_action_create(void);
+
+/**
+ * @brief Free a message along with its header, attributes, actions
+ * and their strings
+ * 
+ * @param msg the message to destroy. Must not be in the message list
+ */
+void message_destroy(full_msg_t *msg);
+
+/**
+ * @brief Take a message out of the message list and destroy it
+ * 
+ * @param msg a message previously given to \ref message_add
+ */
+void message_remove(full_msg_t *msg);
+
 /**
  * @brief Return a count of the messages in the list
  * 
@@ -37,6 +78,9 @@ uint16_t message_count(void);
 /**
  * @brief Add \ref full_msg_t message to the message stack
  * 
+ * The list takes ownership. Once it holds more than it keeps, or the
+ * message heap runs out, the oldest messages are destroyed.
+ * 
  * @param full_msg_t the pebble message to add
  */
 void message_add(full_msg_t *msg);
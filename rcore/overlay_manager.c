@@ -62,12 +62,12 @@ void overlay_window_create_with_context(OverlayCreateCallback creation_callback,
     xQueueSendToBack(_overlay_queue, &om, 0);
 }
 
-void overlay_window_draw(void)
+bool overlay_window_draw(TickType_t timeout)
 {
     OverlayMessage om = (OverlayMessage) {
         .command = OVERLAY_DRAW,
     };
-    xQueueSendToBack(_overlay_queue, &om, 0);
+    return xQueueSendToBack(_overlay_queue, &om, timeout) == pdTRUE;
 }
 
 
@@ -181,6 +181,17 @@ bool overlay_window_stack_contains_window(Window *window)
     return false;
 }
 
+bool overlay_window_is_dirty(void)
+{
+    OverlayWindow *w;
+    list_foreach(w, &_overlay_window_list_head, OverlayWindow, node)
+    {
+        if (w->window.is_render_scheduled)
+            return true;
+    }
+    return false;
+}
+
 bool overlay_window_accepts_keypress(void)
 {
    return overlay_window_get_next_window_with_click_config() != NULL;
@@ -262,10 +273,7 @@ static void _overlay_window_draw(void)
         window->is_render_scheduled = false;
     }
 
-    /* We get to call it. Final draw is done here */
-    rbl_draw();
-
-    /* notify the running app we are done redrawing */
+    /* notify the compositor we are done; it pushes the frame out */
     xTaskNotifyGive(appthread->task_handle);
 }
 
@@ -313,8 +321,11 @@ static void _overlay_thread(void *pvParameters)
             
             /* When we need to update draw, we post it to the main app. This way
              * we guarantee the background is drawn first.
-             * App thread will then defer back to this thread to draw any overlays */
+             * App thread's compositor will then defer back to this thread to
+             * draw any overlays */
             appmanager_post_draw_message();
         }
+        
+        app_frame_reset();
     }
 }
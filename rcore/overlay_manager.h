@@ -55,6 +55,7 @@ void overlay_window_init(void);
 
 /* Internal. Check if any overlays or windows want a keypress */
 bool overlay_window_accepts_keypress(void);
+bool overlay_window_is_dirty(void);
 void overlay_window_post_button_message(ButtonMessage *message);
 
 
@@ -78,11 +79,13 @@ void overlay_window_create(OverlayCreateCallback creation_callback);
 void overlay_window_create_with_context(OverlayCreateCallback creation_callback, void *context);
 
 /** 
- * @brief Directly draw an \ref OverlayWindow.
+ * @brief Ask the overlay thread to draw every \ref OverlayWindow.
  * 
- * This will also cause a full redraw of all \ref Window objects
+ * Only for the compositor, which waits to be notified that it is done
+ * @param timeout How long to wait for room in the overlay thread's queue
+ * @return true if the overlay thread will draw and notify
  */
-void overlay_window_draw(void);
+bool overlay_window_draw(TickType_t timeout);
 
 /**
  * @brief Clean up an \ref OverlayWindow.
@@ -6,6 +6,14 @@
  */
 
 #include "power.h"
+#include "task.h"
+#include "platform.h"
+#include "debug.h"
+
+/* Longest the RTC wakeup timer can be set for */
+#define POWER_SLEEP_MAX_MS 30000
+
+static power_sleep_stats_t _sleep_stats;
 
 void power_init()
 {
@@ -20,3 +28,129 @@ uint16_t power_get_battery_level(void)
 {
     return 0;
 }
+
+void power_get_sleep_stats(power_sleep_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _sleep_stats;
+    taskEXIT_CRITICAL();
+}
+
+#if configUSE_TICKLESS_IDLE == 2
+/* A day of RTC time, which is where rtc_get_subseconds_of_day wraps */
+#define POWER_RTC_DAY (24UL * 60 * 60 * RTC_SUBSECOND_HZ)
+
+/* Longest we go on one RTC reference without sleeping before we take a
+ * fresh one, well inside the day the RTC can tell apart */
+#define POWER_RESYNC_TICKS pdMS_TO_TICKS(60 * 60 * 1000UL)
+
+/* The kernel is kept to the RTC from a reference point: RTC time
+ * _sync_rtc was _sync_cycles SysTick cycles into tick _sync_tick. Every
+ * wakeup works out where the kernel should be from there, and moves the
+ * reference up to match. The RTC's 1/256s rounding and the part of a tick
+ * either side of a sleep are carried that way, rather than lost each time */
+static uint8_t _sync_valid;
+static uint32_t _sync_rtc;
+static TickType_t _sync_tick;
+static uint32_t _sync_cycles;
+
+/*
+ * Called by the idle task when nothing is due for at least
+ * configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks. Rather than take a
+ * SysTick every 5ms, sleep until the next task is due (or an interrupt
+ * comes in), then move the tick count on by however long we were out and
+ * restart the SysTick part way through a tick, as the stock port does
+ */
+void vPortSuppressTicksAndSleep(TickType_t idle_ticks)
+{
+    const uint32_t tick_cycles = configCPU_CLOCK_HZ / configTICK_RATE_HZ;
+    uint8_t stopped;
+
+    if (idle_ticks > pdMS_TO_TICKS(POWER_SLEEP_MAX_MS))
+        idle_ticks = pdMS_TO_TICKS(POWER_SLEEP_MAX_MS);
+
+    /* PRIMASK rather than BASEPRI, so a masked interrupt still ends the WFI */
+    __disable_irq();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        __enable_irq();
+        return;
+    }
+
+    /* How far into the current tick we are. If the SysTick wrapped after
+     * we masked interrupts, that tick is counted here instead */
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t cycles = SysTick->LOAD - SysTick->VAL;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+        cycles += tick_cycles;
+    }
+
+    uint32_t start = rtc_get_subseconds_of_day();
+    if (!_sync_valid || (int32_t)(tick - _sync_tick) > (int32_t)POWER_RESYNC_TICKS)
+    {
+        _sync_rtc = start;
+        _sync_tick = tick;
+        _sync_cycles = cycles;
+        _sync_valid = 1;
+    }
+
+    uint32_t runtime = debug_runtime_counter();
+    stopped = hw_power_sleep(idle_ticks * portTICK_PERIOD_MS);
+    uint32_t end = rtc_get_subseconds_of_day();
+
+    uint32_t slept = end >= start ? end - start : end + POWER_RTC_DAY - start;
+    debug_runtime_slept(runtime, (uint64_t)slept * 1000000 / RTC_SUBSECOND_HZ);
+
+    /* Where the kernel is, and where the RTC says it should be, in cycles
+     * from the start of the reference tick. The kernel can be a little
+     * behind the reference, if it still owes time from last sleep */
+    TickType_t base = _sync_tick;
+    uint32_t since = end >= _sync_rtc ? end - _sync_rtc : end + POWER_RTC_DAY - _sync_rtc;
+    int64_t now = (int64_t)(int32_t)(tick - base) * tick_cycles + cycles;
+    int64_t due = _sync_cycles + (int64_t)since * configCPU_CLOCK_HZ / RTC_SUBSECOND_HZ;
+
+    _sync_rtc = end;
+    _sync_tick = base + due / tick_cycles;
+    _sync_cycles = due % tick_cycles;
+
+    /* Never go backwards. If the kernel got ahead of the RTC while awake,
+     * it stands still until the RTC catches up */
+    if (due < now)
+        due = now;
+
+    TickType_t ticks = base + due / tick_cycles - tick;
+    uint32_t phase = due % tick_cycles;
+
+    /* the wakeup timer is a little coarser than we are. Whatever doesn't
+     * fit is still owed by the reference, and made up next time */
+    if (ticks > idle_ticks)
+    {
+        ticks = idle_ticks;
+        phase = 0;
+    }
+
+    /* Run out what is left of this tick, then back to whole ticks. The
+     * new LOAD only takes effect at the next reload */
+    uint32_t reload = tick_cycles - phase;
+    SysTick->LOAD = (reload > 1 ? reload : 2) - 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = tick_cycles - 1;
+
+    vTaskStepTick(ticks);
+
+    _sleep_stats.sleeps++;
+    _sleep_stats.ticks_slept += ticks;
+    if (stopped)
+    {
+        _sleep_stats.stops++;
+        _sleep_stats.ticks_stopped += ticks;
+    }
+
+    __enable_irq();
+}
+#endif
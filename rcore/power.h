@@ -11,3 +11,14 @@
 void power_init();
 void power_off();
 uint16_t power_get_battery_level(void);
+
+/* How the idle task has slept, since boot. All zero on platforms
+ * without tickless idle */
+typedef struct power_sleep_stats_t {
+    uint32_t sleeps;        /* times we slept, each ending in a wakeup */
+    uint32_t stops;         /* of which were in STOP mode */
+    uint32_t ticks_slept;
+    uint32_t ticks_stopped;
+} power_sleep_stats_t;
+
+void power_get_sleep_stats(power_sleep_stats_t *stats);
@@ -33,12 +33,9 @@ void notification_packet_push(uint8_t *data, full_msg_t **message)
 
     SYS_LOG("PHPKT", APP_LOG_LEVEL_INFO, "X attrc %d actc %d", msg->attr_count, msg->action_count);
     
-    new_msg = noty_calloc(1, sizeof(full_msg_t));
+    new_msg = message_create();
     assert(new_msg);
-    new_msg->header = noty_calloc(1, sizeof(cmd_phone_notify_t));
     memcpy(new_msg->header, msg, sizeof(cmd_phone_notify_t));
-    list_init_head(&new_msg->attributes_list_head);
-    list_init_head(&new_msg->actions_list_head);
     
     /* get the attributes */
     uint8_t *p = data + sizeof(cmd_phone_notify_t);
@@ -48,7 +45,8 @@ void notification_packet_push(uint8_t *data, full_msg_t **message)
         cmd_phone_attribute_hdr_t *att = (cmd_phone_attribute_hdr_t *)p;
         uint8_t *data = p + sizeof(cmd_phone_attribute_hdr_t);
         SYS_LOG("PHPKT", APP_LOG_LEVEL_INFO, "X ATTR ID:%d L:%d", att->attr_idx, att->str_len);
-        cmd_phone_attribute_t *new_attr = noty_calloc(1, sizeof(cmd_phone_attribute_t));
+        cmd_phone_attribute_t *new_attr = message_attribute_create();
+        assert(new_attr);
         /* copy the head to the new attribute */
         memcpy(new_attr, att, sizeof(cmd_phone_attribute_hdr_t));
         /* copy the data in now */
@@ -68,7 +66,8 @@ void notification_packet_push(uint8_t *data, full_msg_t **message)
         cmd_phone_action_hdr_t *act = (cmd_phone_action_hdr_t *)p;
         uint8_t *data = p + sizeof(cmd_phone_action_hdr_t);
         SYS_LOG("PHPKT", APP_LOG_LEVEL_INFO, "X ACT ID:%d L:%d AID:%d ALEN:%d", act->id, act->attr_count, act->attr_id, act->str_len);
-        cmd_phone_action_t *new_act = noty_calloc(1, sizeof(cmd_phone_action_t));
+        cmd_phone_action_t *new_act = message_action_create();
+        assert(new_act);
         /* copy the head to the new action */
         memcpy(new_act, act, sizeof(cmd_phone_action_hdr_t));
         /* copy the data in now */
@@ -86,40 +85,6 @@ void notification_packet_push(uint8_t *data, full_msg_t **message)
     *message = new_msg;
 }
 
-void _full_msg_free(full_msg_t *message)
-{  
-    cmd_phone_attribute_t *m;
-    list_node *l = list_get_head(&message->attributes_list_head);
-    while(l)
-    {
-        m = list_elem(l, cmd_phone_attribute_t, node);
-        list_remove(&message->attributes_list_head, &m->node);
-        /* free the string */
-        noty_free(m->data);
-        /* free the attribute */
-        noty_free(m);
-    }
-    
-    cmd_phone_action_t *a;
-    l = list_get_head(&message->actions_list_head);
-    while(l)
-    {
-        a = list_elem(l, cmd_phone_action_t, node);
-        list_remove(&message->actions_list_head, &a->node);
-        
-        /* free the string */
-        noty_free(a->data);
-        /* free the attribute */
-        noty_free(a);
-    }
-    
-    noty_free(message->header);
-    message->header = NULL;
-    noty_free(message);
-    message = NULL;
-}
-
-
 /* we have pesky pascal strings. Turn them into null term strings */
 static void _copy_and_null_term_string(uint8_t **dest, uint8_t *src, uint16_t len)
 {
@@ -7,6 +7,39 @@
  */
 
 #include "rebbleos.h"
+#include "protocol_notification.h"
+#include "notification_message.h"
+
+/* System heap allocations are tagged with who made them, so the RTOS heap
+ * can be sized from what is actually in it. Kernel objects (queues, tasks)
+ * are allocated by FreeRTOS directly and show up as the untagged rest.
+ * Callers hash into the site table, so a lookup is a probe or two. Slots
+ * are claimed and counted with atomics rather than by stopping the
+ * scheduler. One more slot past the table collects anything that doesn't
+ * fit */
+#define SYSTEM_HEAP_SITES 16 /* a power of two */
+#define SYSTEM_HEAP_OVERFLOW SYSTEM_HEAP_SITES
+/* In every tag, so system_free can tell it was given one of ours */
+#define SYSTEM_HEAP_MAGIC 0x7A65
+
+/* Keeps the allocation portBYTE_ALIGNMENT aligned */
+typedef struct system_heap_tag {
+    uint16_t site;
+    uint16_t magic;
+    uint32_t size;
+} system_heap_tag;
+
+typedef struct system_heap_site {
+    void *caller; /* NULL until claimed; always NULL in the overflow slot */
+    uint32_t live;
+    uint32_t bytes;
+    uint32_t peak;
+} system_heap_site;
+
+static system_heap_site _system_heap_sites[SYSTEM_HEAP_SITES + 1];
+
+static void *_system_alloc(size_t size, void *caller);
+static uint16_t _system_heap_site(void *caller);
 
 void rblos_memory_init(void)
 {
@@ -17,7 +50,7 @@ void *system_calloc(size_t count, size_t size)
     if (!appmanager_is_thread_system())
         KERN_LOG("main", APP_LOG_LEVEL_DEBUG, "XXX System Calloc. Check who did this");
     
-    void *x = pvPortMalloc(count * size);
+    void *x = _system_alloc(count * size, __builtin_return_address(0));
     if (x != NULL)
         memset(x, 0, count * size);
     return x;
@@ -27,7 +60,76 @@ void *system_malloc(size_t size)
 {
     if (appmanager_is_thread_system())
         KERN_LOG("main", APP_LOG_LEVEL_DEBUG, "XXX System Malloc. Check who did this");
-    return pvPortMalloc(size);
+    return _system_alloc(size, __builtin_return_address(0));
+}
+
+void system_free(void *mem)
+{
+    if (mem == NULL)
+        return;
+    
+    /* anything straight from pvPortMalloc has a heap_4 header here, whose
+     * allocated block link is NULL; it must go back through vPortFree */
+    system_heap_tag *tag = (system_heap_tag *)mem - 1;
+    assert(tag->magic == SYSTEM_HEAP_MAGIC && "system_free of a block not from system_malloc");
+    tag->magic = 0;
+    
+    system_heap_site *site = &_system_heap_sites[tag->site];
+    __atomic_fetch_sub(&site->live, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_sub(&site->bytes, tag->size, __ATOMIC_RELAXED);
+    
+    vPortFree(tag);
+}
+
+/*
+ * Find the caller's slot, claiming a free one if it has none yet
+ */
+static uint16_t _system_heap_site(void *caller)
+{
+    /* return addresses are halfword aligned, and callers cluster */
+    uint32_t hash = ((uint32_t)caller >> 1) * 2654435761u;
+    uint16_t start = hash >> 16;
+    
+    for (uint16_t n = 0; n < SYSTEM_HEAP_SITES; n++)
+    {
+        uint16_t i = (start + n) & (SYSTEM_HEAP_SITES - 1);
+        void *owner = __atomic_load_n(&_system_heap_sites[i].caller, __ATOMIC_RELAXED);
+        
+        if (owner == NULL)
+        {
+            /* if someone beat us to it, owner now says who */
+            if (__atomic_compare_exchange_n(&_system_heap_sites[i].caller, &owner, caller, false,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return i;
+        }
+        if (owner == caller)
+            return i;
+    }
+    
+    return SYSTEM_HEAP_OVERFLOW;
+}
+
+static void *_system_alloc(size_t size, void *caller)
+{
+    system_heap_tag *tag = pvPortMalloc(sizeof(system_heap_tag) + size);
+    if (tag == NULL)
+        return NULL;
+    
+    uint16_t i = _system_heap_site(caller);
+    system_heap_site *site = &_system_heap_sites[i];
+    __atomic_fetch_add(&site->live, 1, __ATOMIC_RELAXED);
+    uint32_t bytes = __atomic_add_fetch(&site->bytes, size, __ATOMIC_RELAXED);
+    uint32_t peak = __atomic_load_n(&site->peak, __ATOMIC_RELAXED);
+    while (bytes > peak &&
+           !__atomic_compare_exchange_n(&site->peak, &peak, bytes, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+    
+    tag->site = i;
+    tag->magic = SYSTEM_HEAP_MAGIC;
+    tag->size = size;
+    
+    return tag + 1;
 }
 
 void *app_malloc(size_t size)
@@ -40,8 +142,18 @@ void *app_calloc(size_t count, size_t size)
     app_running_thread *thread = appmanager_get_current_thread();
     assert(thread && "invalid thread");
     void *x = qalloc(thread->arena, count * size);
+    /* if we have movable blocks, they might be in the way */
+    if (x == NULL && thread->arena->handles && qcompact(thread->arena) >= count * size)
+        x = qalloc(thread->arena, count * size);
+    
     if (x != NULL)
         memset(x, 0, count * size);
+    else
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "app_calloc of %d bytes failed", count * size);
+        /* app heaps are numbered the same as their threads */
+        heap_stats_log((HeapId)thread->thread_type);
+    }
     return x;
 }
 
@@ -50,3 +162,390 @@ void app_free(void *mem)
     app_running_thread *thread = appmanager_get_current_thread();
     qfree(thread->arena, mem);
 }
+
+/* Movable blocks */
+
+app_handle_t app_handle_alloc(size_t size)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    assert(thread && "invalid thread");
+    
+    /* qhalloc compacts for itself if it has to */
+    app_handle_t handle = qhalloc(thread->arena, size);
+    if (handle == NULL)
+    {
+        /* not always an error, callers can fall back to a fixed block */
+        KERN_LOG("memory", APP_LOG_LEVEL_DEBUG, "app_handle_alloc of %d bytes failed, %d handles left",
+                 size, qhavail(thread->arena));
+        return NULL;
+    }
+    memset(handle->ptr, 0, size);
+    
+    return handle;
+}
+
+void app_handle_free(app_handle_t handle)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    qhfree(thread->arena, handle);
+}
+
+void *app_handle_lock(app_handle_t handle)
+{
+    return qhlock(handle);
+}
+
+void app_handle_unlock(app_handle_t handle)
+{
+    qhunlock(handle);
+}
+
+/*
+ * Move unlocked handles together so the free space between them merges.
+ * Returns the largest allocation that can now succeed
+ */
+size_t app_heap_compact(void)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    assert(thread && "invalid thread");
+    
+    return qcompact(thread->arena);
+}
+
+/* Frame arenas */
+
+/* A frame allocation that didn't fit, kept on the heap until release */
+struct frame_overflow {
+    struct frame_overflow *next;
+};
+
+#define FRAME_ALIGN(s) (((s) + 3) & ~3)
+
+static frame_arena_t *_frame_arena(app_running_thread **thread)
+{
+    *thread = appmanager_get_current_thread();
+    assert(*thread && "invalid thread");
+    return &(*thread)->frame;
+}
+
+/*
+ * Get size bytes of scratch memory. It is not zeroed. It is reclaimed
+ * when the thread's runloop finishes the current event, or sooner with
+ * app_frame_mark/app_frame_release around the code using it
+ */
+void *app_frame_alloc(size_t size)
+{
+    app_running_thread *thread;
+    frame_arena_t *frame = _frame_arena(&thread);
+
+    /* claim our block the first time round */
+    if (frame->base == NULL)
+    {
+        frame->base = qalloc(thread->arena, MEMORY_SIZE_FRAME_ARENA);
+        frame->size = frame->base ? MEMORY_SIZE_FRAME_ARENA : 0;
+        frame->top = 0;
+    }
+
+    size = FRAME_ALIGN(size);
+    if (size <= frame->size - frame->top)
+    {
+        void *x = frame->base + frame->top;
+        frame->top += size;
+        return x;
+    }
+
+    struct frame_overflow *over = qalloc(thread->arena, sizeof(struct frame_overflow) + size);
+    if (over == NULL)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "app_frame_alloc of %d bytes failed", size);
+        heap_stats_log((HeapId)thread->thread_type);
+        return NULL;
+    }
+    over->next = frame->overflow;
+    frame->overflow = over;
+
+    return over + 1;
+}
+
+frame_mark_t app_frame_mark(void)
+{
+    app_running_thread *thread;
+    frame_arena_t *frame = _frame_arena(&thread);
+
+    return (frame_mark_t) { .top = frame->top, .overflow = frame->overflow };
+}
+
+/*
+ * Give back everything frame allocated since mark was taken
+ */
+void app_frame_release(frame_mark_t mark)
+{
+    app_running_thread *thread;
+    frame_arena_t *frame = _frame_arena(&thread);
+
+    while (frame->overflow && frame->overflow != mark.overflow)
+    {
+        struct frame_overflow *over = frame->overflow;
+        frame->overflow = over->next;
+        qfree(thread->arena, over);
+    }
+
+    if (mark.top < frame->top)
+        frame->top = mark.top;
+}
+
+/*
+ * Called by the runloops once each event has been handled
+ */
+void app_frame_reset(void)
+{
+    app_frame_release((frame_mark_t) { .top = 0, .overflow = NULL });
+}
+
+/* Object pools */
+
+/*
+ * Set aside room for count objects of size bytes in one block of the
+ * calling thread's heap. An app would do this once at startup with
+ * the most of that object it expects to have alive at a time
+ */
+bool app_pool_reserve(AppPoolId pool, size_t size, uint16_t count)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    assert(thread && "invalid thread");
+    app_pool_t *p = &thread->pools[pool];
+
+    if (p->base)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "Pool %d is already reserved", pool);
+        return false;
+    }
+
+    /* free slots keep their next pointer in the object */
+    if (size < sizeof(void *))
+        size = sizeof(void *);
+    uint16_t stride = (size + 3) & ~3;
+    uint8_t *base = qalloc(thread->arena, stride * count);
+    if (base == NULL)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "No room to pool %d objects of %d bytes", count, size);
+        return false;
+    }
+
+    p->base = base;
+    p->end = base + stride * count;
+    p->stride = stride;
+    p->inuse = 0;
+    p->free = NULL;
+    for (uint16_t i = count; i > 0; i--)
+    {
+        void *slot = base + (i - 1) * stride;
+        *(void **)slot = p->free;
+        p->free = slot;
+    }
+
+    return true;
+}
+
+void *app_pool_calloc(AppPoolId pool, size_t size)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    assert(thread && "invalid thread");
+    app_pool_t *p = &thread->pools[pool];
+
+    if (p->free == NULL || size > p->stride)
+        return app_calloc(1, size);
+
+    void *x = p->free;
+    p->free = *(void **)x;
+    p->inuse++;
+    memset(x, 0, size);
+
+    return x;
+}
+
+void app_pool_free(AppPoolId pool, void *mem)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    assert(thread && "invalid thread");
+    app_pool_t *p = &thread->pools[pool];
+
+    if ((uint8_t *)mem < p->base || (uint8_t *)mem >= p->end)
+    {
+        qfree(thread->arena, mem);
+        return;
+    }
+
+    *(void **)mem = p->free;
+    p->free = mem;
+    p->inuse--;
+}
+
+static const char *_heap_names[HeapCount] = {
+    [HeapApp] = "app",
+    [HeapWorker] = "worker",
+    [HeapOverlay] = "overlay",
+    [HeapNotification] = "notification",
+};
+
+static qarena_t *_heap_arena(HeapId heap)
+{
+    switch (heap)
+    {
+        case HeapApp:
+            return appmanager_get_thread(AppThreadMainApp)->arena;
+        case HeapWorker:
+            return appmanager_get_thread(AppThreadWorker)->arena;
+        case HeapOverlay:
+            return appmanager_get_thread(AppThreadOverlay)->arena;
+        case HeapNotification:
+            return messages_get_arena();
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * Get a snapshot of an arena's usage. This is cheap, the allocator
+ * keeps running totals, so it's fine to call from anywhere.
+ * Returns false if that arena isn't set up yet
+ */
+bool heap_stats(HeapId heap, heap_stats_t *stats)
+{
+    qarena_t *arena = _heap_arena(heap);
+    if (arena == NULL)
+        return false;
+
+    qstats(arena, stats);
+    return true;
+}
+
+const char *heap_stats_name(HeapId heap)
+{
+    return heap < HeapCount ? _heap_names[heap] : "?";
+}
+
+void heap_stats_log(HeapId heap)
+{
+    heap_stats_t stats;
+    if (!heap_stats(heap, &stats))
+        return;
+
+    KERN_LOG("memory", APP_LOG_LEVEL_INFO, "%s heap: %d/%d used, peak %d, largest free %d in %d blocks, %d failed",
+             heap_stats_name(heap), stats.used, stats.size, stats.peak,
+             stats.largest_free, stats.free_blocks, stats.alloc_fails);
+}
+
+void heap_stats_log_all(void)
+{
+    for (HeapId heap = 0; heap < HeapCount; heap++)
+        heap_stats_log(heap);
+}
+
+/*
+ * The RTOS heap, and who is using it. Callers are return addresses,
+ * look them up with addr2line
+ */
+void system_heap_log(void)
+{
+    size_t tagged = 0;
+    
+    KERN_LOG("memory", APP_LOG_LEVEL_INFO, "system heap: %d/%d free, least ever free %d",
+             xPortGetFreeHeapSize(), configTOTAL_HEAP_SIZE, xPortGetMinimumEverFreeHeapSize());
+    
+    for (uint16_t i = 0; i <= SYSTEM_HEAP_OVERFLOW; i++)
+    {
+        system_heap_site *site = &_system_heap_sites[i];
+        if (site->peak == 0)
+            continue;
+        
+        KERN_LOG("memory", APP_LOG_LEVEL_INFO, "  0x%x: %d bytes in %d, peak %d",
+                 site->caller, site->bytes, site->live, site->peak);
+        tagged += site->bytes + site->live * sizeof(system_heap_tag);
+    }
+    
+    KERN_LOG("memory", APP_LOG_LEVEL_INFO, "  kernel and block headers: %d bytes",
+             configTOTAL_HEAP_SIZE - xPortGetFreeHeapSize() - tagged);
+}
+
+/*
+ * How close each task has come to the end of its stack
+ */
+void task_stack_log(void)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = pvPortMalloc(count * sizeof(TaskStatus_t));
+    if (tasks == NULL)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "No memory for the task list");
+        return;
+    }
+    
+    count = uxTaskGetSystemState(tasks, count, NULL);
+    for (UBaseType_t i = 0; i < count; i++)
+        KERN_LOG("memory", APP_LOG_LEVEL_INFO, "%s stack: %d words never used",
+                 tasks[i].pcTaskName, tasks[i].usStackHighWaterMark);
+    
+    vPortFree(tasks);
+}
+
+void memory_report_log(void)
+{
+    system_heap_log();
+    task_stack_log();
+    heap_stats_log_all();
+}
+
+/*
+ * The most memory the calling app has needed so far: its image, the
+ * peak of its heap and the deepest its stack has gone
+ */
+size_t app_memory_footprint(void)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    qstats_t stats;
+
+    qstats(thread->arena, &stats);
+    /* the arena starts straight after the app's image and bss */
+    size_t image = (uint8_t *)thread->arena - thread->heap;
+    size_t stack = (thread->stack_size - uxTaskGetStackHighWaterMark(NULL)) * sizeof(StackType_t);
+
+    return image + stats.peak + stack;
+}
+
+/*
+ * Log what the calling app has used. Apps we ship are checked against
+ * MEMORY_BUDGET_SYSTEM_APP, so a regression shows up on any platform
+ * and not just once it no longer fits on tintin.
+ * Returns false if an app we ship went over, or its heap ran out
+ */
+bool app_memory_check_budget(void)
+{
+    app_running_thread *thread = appmanager_get_current_thread();
+    qstats_t stats;
+
+    qstats(thread->arena, &stats);
+    size_t footprint = app_memory_footprint();
+
+    KERN_LOG("memory", APP_LOG_LEVEL_INFO, "%s: %d bytes at peak (heap %d, now %d), budget %d",
+             thread->app->name, footprint, stats.peak, stats.used, MEMORY_BUDGET_SYSTEM_APP);
+
+    if (!thread->app->is_internal)
+        return true;
+
+    bool ok = true;
+    if (footprint > MEMORY_BUDGET_SYSTEM_APP)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "%s is %d bytes over its memory budget",
+                 thread->app->name, footprint - MEMORY_BUDGET_SYSTEM_APP);
+        ok = false;
+    }
+    if (stats.alloc_fails)
+    {
+        KERN_LOG("memory", APP_LOG_LEVEL_ERROR, "%s ran out of heap %d times",
+                 thread->app->name, stats.alloc_fails);
+        ok = false;
+    }
+
+    return ok;
+}
@@ -11,15 +11,110 @@
 #include <string.h>
 #include <stdlib.h>
 #include "stdbool.h"
+#include "qalloc.h"
 
 #define malloc system_malloc
 #define calloc system_calloc
-#define free vPortFree
+#define free system_free
 
 void *system_calloc(size_t count, size_t size);
 void rblos_memory_init(void);
 void *system_malloc(size_t size);
+void system_free(void *mem);
 
 void *app_malloc(size_t size);
 void *app_calloc(size_t count, size_t size);
 void app_free(void *mem);
+
+/* Frame allocations are scratch memory that only lives until the thread
+ * finishes handling the current event (or an earlier app_frame_release).
+ * They are a pointer bump out of a block kept on the thread's heap, so
+ * short lived buffers don't fragment it. Anything that doesn't fit falls
+ * back to the heap and is freed along with the rest */
+struct frame_overflow;
+
+typedef struct frame_arena_t {
+    uint8_t *base;
+    uint16_t size;
+    uint16_t top;
+    struct frame_overflow *overflow;
+} frame_arena_t;
+
+typedef struct frame_mark_t {
+    uint16_t top;
+    struct frame_overflow *overflow;
+} frame_mark_t;
+
+void *app_frame_alloc(size_t size);
+frame_mark_t app_frame_mark(void);
+void app_frame_release(frame_mark_t mark);
+void app_frame_reset(void);
+
+/* Handles are for big, long lived buffers (bitmaps, resources). The
+ * block behind a handle can be moved to gather up free space when the
+ * heap gets fragmented, so lock it while using the data and unlock it
+ * again when done. A failed app_calloc compacts the heap and retries.
+ * There are only QALLOC_NHANDLES per heap, so be ready for
+ * app_handle_alloc to fail and fall back to app_calloc */
+typedef qhandle_t app_handle_t;
+
+app_handle_t app_handle_alloc(size_t size);
+void app_handle_free(app_handle_t handle);
+void *app_handle_lock(app_handle_t handle);
+void app_handle_unlock(app_handle_t handle);
+size_t app_heap_compact(void);
+
+/* Pools are optional per-app free lists of fixed size UI objects.
+ * Once an app reserves one, that object's create and destroy are O(1)
+ * and stay out of the general heap. Without a reservation, or when a
+ * pool runs dry, objects come from the heap as usual */
+typedef enum AppPoolId {
+    AppPoolWindow,
+    AppPoolLayer,
+    AppPoolTextLayer,
+    AppPoolAnimation,
+    AppPoolPropertyAnimation,
+    AppPoolCount,
+} AppPoolId;
+
+typedef struct app_pool_t {
+    uint8_t *base;
+    uint8_t *end;
+    void *free;
+    uint16_t stride;
+    uint16_t inuse;
+} app_pool_t;
+
+bool app_pool_reserve(AppPoolId pool, size_t size, uint16_t count);
+void *app_pool_calloc(AppPoolId pool, size_t size);
+void app_pool_free(AppPoolId pool, void *mem);
+
+/* The arenas heap_stats can report on */
+typedef enum HeapId {
+    HeapApp,
+    HeapWorker,
+    HeapOverlay,
+    HeapNotification,
+    HeapCount,
+} HeapId;
+
+typedef qstats_t heap_stats_t;
+
+bool heap_stats(HeapId heap, heap_stats_t *stats);
+const char *heap_stats_name(HeapId heap);
+void heap_stats_log(HeapId heap);
+void heap_stats_log_all(void);
+
+void system_heap_log(void);
+void task_stack_log(void);
+void memory_report_log(void);
+
+/* Apps we ship have to run on every platform, so they are held to the
+ * smallest app budget (tintin's) whatever they run on: image, heap high
+ * water mark and deepest stack together. A platform may set its own */
+#ifndef MEMORY_BUDGET_SYSTEM_APP
+#define MEMORY_BUDGET_SYSTEM_APP 40000
+#endif
+
+size_t app_memory_footprint(void);
+bool app_memory_check_budget(void);
@@ -113,6 +113,15 @@ void resource_load_app(ResHandle resource_handle, uint8_t *buffer, const struct
     
     KERN_LOG("resou", APP_LOG_LEVEL_DEBUG, "Res: Start %p", APP_RES_START + resource_handle.offset);
     
+    resource_load_app_partial(resource_handle, buffer, 0, resource_handle.size, file);
+}
+
+/*
+ * Load size bytes of an app resource, starting offset bytes into it.
+ * Handy for peeking at a header before committing to a full load
+ */
+void resource_load_app_partial(ResHandle resource_handle, uint8_t *buffer, size_t offset, size_t size, const struct file *file)
+{
     uint16_t ofs = 0xC;
     
 //     if (resource_handle.index > 1)
@@ -121,9 +130,8 @@ void resource_load_app(ResHandle resource_handle, uint8_t *buffer, const struct
 
     struct fd fd;
     fs_open(&fd, file);
-    fs_seek(&fd, APP_RES_START + resource_handle.offset + ofs, FS_SEEK_SET);
-    fs_read(&fd, buffer, resource_handle.size);
-    return;
+    fs_seek(&fd, APP_RES_START + resource_handle.offset + ofs + offset, FS_SEEK_SET);
+    fs_read(&fd, buffer, size);
 }
 
 /*
@@ -168,12 +176,19 @@ void resource_load_system(ResHandle resource_handle, uint8_t *buffer)
 //         return;
 //     }
     
+    resource_load_system_partial(resource_handle, buffer, 0, resource_handle.size);
+}
+
+/*
+ * Load size bytes of a system resource, starting offset bytes into it
+ */
+void resource_load_system_partial(ResHandle resource_handle, uint8_t *buffer, size_t offset, size_t size)
+{
     xSemaphoreTake(_res_mutex, portMAX_DELAY);
     
-    flash_read_bytes(REGION_RES_START + RES_START + resource_handle.offset, buffer, resource_handle.size);
+    flash_read_bytes(REGION_RES_START + RES_START + resource_handle.offset + offset, buffer, size);
     
     xSemaphoreGive(_res_mutex);
-
 }
 
 /*
@@ -267,6 +282,35 @@ uint8_t *resource_fully_load_res_app(ResHandle res_handle, const struct file *fi
     
 
 
+/*
+ * Load a resource fully into a movable block, which is easier to find room
+ * for once the heap is fragmented. Lock the handle to get at the data.
+ * file is NULL for a system resource
+ */
+app_handle_t resource_fully_load_res_handle(ResHandle res_handle, const struct file *file)
+{
+    if (!_resource_is_sane(res_handle))
+        return NULL;
+    
+    size_t sz = resource_size(res_handle);
+    
+    app_handle_t handle = app_handle_alloc(sz);
+    if (handle == NULL)
+    {
+        KERN_LOG("resou", APP_LOG_LEVEL_ERROR, "Resource alloc of %d bytes for res %d failed", sz, res_handle.index);
+        return NULL;
+    }
+    
+    uint8_t *buffer = app_handle_lock(handle);
+    if (file)
+        resource_load_app(res_handle, buffer, file);
+    else
+        resource_load_system(res_handle, buffer);
+    app_handle_unlock(handle);
+    
+    return handle;
+}
+
 /*
  * 
  * 
@@ -7,6 +7,7 @@
  */
 
 #include "graphics_reshandle.h"
+#include "rebble_memory.h"
 
 struct file;
 
@@ -16,8 +17,11 @@ ResHandle resource_get_handle_system(uint16_t resource_id);
 ResHandle resource_get_handle_app(uint32_t resource_id, const struct file *file);
 void resource_load_app(ResHandle resource_handle, uint8_t *buffer, const struct file *file);
 void resource_load_system(ResHandle resource_handle, uint8_t *buffer);
+void resource_load_app_partial(ResHandle resource_handle, uint8_t *buffer, size_t offset, size_t size, const struct file *file);
+void resource_load_system_partial(ResHandle resource_handle, uint8_t *buffer, size_t offset, size_t size);
 size_t resource_size(ResHandle handle);
 uint8_t *resource_fully_load_id_app(uint16_t resource_id, const struct file *file);
 uint8_t *resource_fully_load_id_system(uint16_t resource_id);
 uint8_t *resource_fully_load_res_system(ResHandle res_handle);
 uint8_t *resource_fully_load_res_app(ResHandle res_handle, const struct file *file);
+app_handle_t resource_fully_load_res_handle(ResHandle res_handle, const struct file *file);
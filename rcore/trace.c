@@ -0,0 +1,102 @@
+/* trace.c
+ * Timestamped record of scheduler, queue and interrupt events
+ * RebbleOS
+ */
+
+#include "rebbleos.h"
+#include "trace.h"
+
+/* Records go to the log four to a line, as hex */
+#define TRACE_DUMP_PER_LINE 4
+
+#ifdef TRACE_RING_RECORDS
+static trace_record _trace_ring[TRACE_RING_RECORDS];
+/* every record ever written; the ring holds the last TRACE_RING_RECORDS */
+static uint32_t _trace_written;
+static volatile uint8_t _trace_paused;
+
+/*
+ * Called from the kernel's trace hooks and from interrupts, so it masks
+ * them just long enough to claim a slot
+ */
+void trace_record_event(uint8_t event, uint8_t arg, uint16_t value)
+{
+    if (_trace_paused)
+        return;
+    
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    trace_record *record = &_trace_ring[_trace_written++ % TRACE_RING_RECORDS];
+    record->time_us = debug_runtime_counter();
+    record->event = event;
+    record->arg = arg;
+    record->value = value;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+uint32_t trace_record_count(void)
+{
+    return _trace_written;
+}
+
+/* The task numbers in the records mean nothing without their names */
+static void _trace_dump_tasks(void)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = pvPortMalloc(count * sizeof(TaskStatus_t));
+    if (tasks == NULL)
+        return;
+    
+    count = uxTaskGetSystemState(tasks, count, NULL);
+    for (UBaseType_t i = 0; i < count; i++)
+        KERN_LOG("trace", APP_LOG_LEVEL_INFO, "trace: task %d %s",
+                 tasks[i].xTaskNumber, tasks[i].pcTaskName);
+    
+    vPortFree(tasks);
+}
+
+/*
+ * Write the ring out to the log, oldest first. Recording stops while we
+ * do, or the dump would fill the ring with its own logging
+ */
+void trace_dump(void)
+{
+    char line[TRACE_DUMP_PER_LINE * 16 + 1];
+    
+    _trace_paused = 1;
+    
+    uint32_t written = _trace_written;
+    uint32_t count = written < TRACE_RING_RECORDS ? written : TRACE_RING_RECORDS;
+    
+    KERN_LOG("trace", APP_LOG_LEVEL_INFO, "trace: begin %d of %d", count, written);
+    _trace_dump_tasks();
+    
+    for (uint32_t i = 0; i < count; i += TRACE_DUMP_PER_LINE)
+    {
+        char *p = line;
+        for (uint32_t j = i; j < count && j < i + TRACE_DUMP_PER_LINE; j++)
+        {
+            trace_record *record = &_trace_ring[(written - count + j) % TRACE_RING_RECORDS];
+            p += snprintf(p, 17, "%08x%02x%02x%04x", (unsigned int)record->time_us,
+                          record->event, record->arg, record->value);
+        }
+        KERN_LOG("trace", APP_LOG_LEVEL_INFO, "trace: rec %s", line);
+    }
+    
+    KERN_LOG("trace", APP_LOG_LEVEL_INFO, "trace: end");
+    
+    _trace_paused = 0;
+}
+
+#else
+
+uint32_t trace_record_count(void)
+{
+    return 0;
+}
+
+void trace_dump(void)
+{
+    KERN_LOG("trace", APP_LOG_LEVEL_INFO, "Built without TRACE_RING_RECORDS; nothing to dump");
+}
+
+#endif
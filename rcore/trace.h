@@ -0,0 +1,50 @@
+#pragma once
+/* trace.h
+ * Timestamped record of scheduler, queue and interrupt events, kept in a
+ * RAM ring so latency problems can be looked at as a timeline.
+ * Decode a dump with Utilities/trace_decode.py
+ * RebbleOS
+ */
+
+#include <stdint.h>
+
+/* Off unless built with -DTRACE_RING_RECORDS=<records>; a power of two
+ * keeps recording cheap */
+
+typedef enum trace_event {
+    TraceTaskSwitchedIn = 1,    /* arg: task number */
+    TraceQueueSend,             /* value: queue */
+    TraceQueueSendFromIsr,
+    TraceQueueReceive,
+    TraceQueueReceiveFromIsr,
+    TraceQueueBlockSend,
+    TraceQueueBlockReceive,
+    TraceIsrEnter,              /* arg: exception number */
+    TraceIsrExit,
+    TraceMark,                  /* arg, value: whatever the caller likes */
+} trace_event;
+
+/* 8 bytes, so a few hundred fit in the spare RAM */
+typedef struct trace_record {
+    uint32_t time_us;
+    uint8_t event;
+    uint8_t arg;
+    uint16_t value;
+} trace_record;
+
+/* Queues are word aligned and all live in the bottom 256k of SRAM */
+#define TRACE_QUEUE(queue) ((uint16_t)((uint32_t)(queue) >> 2))
+
+#ifdef TRACE_RING_RECORDS
+void trace_record_event(uint8_t event, uint8_t arg, uint16_t value);
+#define TRACE_ISR_ENTER() trace_record_event(TraceIsrEnter, __get_IPSR(), 0)
+#define TRACE_ISR_EXIT() trace_record_event(TraceIsrExit, __get_IPSR(), 0)
+#define TRACE_MARK(arg, value) trace_record_event(TraceMark, arg, value)
+#else
+#define TRACE_ISR_ENTER()
+#define TRACE_ISR_EXIT()
+#define TRACE_MARK(arg, value)
+#endif
+
+uint32_t trace_record_count(void);
+void trace_dump(void);
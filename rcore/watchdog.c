@@ -7,8 +7,13 @@
 
 #include "platform.h" /* WATCHDOG_RESET_MS */
 #include "task.h" /* xTaskCreate, vTaskDelay */
+#include "appmanager.h" /* appmanager_watchdog_check */
 
-static StackType_t _watchdog_stack[configMINIMAL_STACK_SIZE];
+/* room for the app hang check, which logs and posts to the manager.
+ * Too big now for what is left of CCRAM, so it stays in SRAM */
+#define WATCHDOG_STACK_SIZE (configMINIMAL_STACK_SIZE + 100)
+
+static StackType_t _watchdog_stack[WATCHDOG_STACK_SIZE];
 static StaticTask_t _watchdog_task;
 static void _threadmain_watchdog(void *pvParameters);
 
@@ -28,9 +33,9 @@ void rcore_watchdog_init_late() {
     (void) xTaskCreateStatic(
         _threadmain_watchdog,             /* Function pointer */
         "rcore_watchdog",               /* Task name - for debugging only*/
-        configMINIMAL_STACK_SIZE,         /* Stack depth in words */
+        WATCHDOG_STACK_SIZE,              /* Stack depth in words */
         (void*) NULL,                     /* Pointer to tasks arguments (parameter) */
-        tskIDLE_PRIORITY + 5UL,           /* Task priority */
+        tskIDLE_PRIORITY + 4UL,           /* Task priority */
         _watchdog_stack,                  /* Stack pointer */
         &_watchdog_task                   /* TCB memory */
         );
@@ -41,6 +46,7 @@ static void _threadmain_watchdog(void *pvParameters)
     while(1)
     {
         hw_watchdog_reset();
+        appmanager_watchdog_check();
         vTaskDelay(WATCHDOG_RESET_MS / portTICK_RATE_MS);
     }
 }
@@ -0,0 +1,224 @@
+/* display_list.c
+ * Record a layer's draw calls once and replay them on later frames
+ * libRebbleOS
+ *
+ * While a layer's update_proc runs, the graphics_* wrappers append a
+ * command for each call here as well as drawing it. Until the layer is
+ * marked dirty, later frames replay the list instead of calling the
+ * update_proc again. Context state is only emitted when it differs from
+ * the last recorded draw, so replays skip redundant state changes.
+ *
+ * Drawing is serialised by the display lock, so there is only ever one
+ * list recording at a time.
+ */
+
+#include "librebble.h"
+#include "display_list.h"
+
+typedef enum DisplayListStatus {
+    DisplayListEmpty,
+    DisplayListValid,
+    DisplayListUnsupported, /* update_proc did something we can't record */
+} DisplayListStatus;
+
+struct DisplayList {
+    uint16_t capacity;
+    uint16_t count;
+    uint8_t status;
+    DisplayListCommand commands[];
+};
+
+static DisplayList *_recording;
+static DisplayListState _recorded_state;
+static bool _recorded_state_valid;
+
+static void _state_from_context(DisplayListState *state, n_GContext *ctx);
+static bool _append(const DisplayListCommand *command);
+
+DisplayList *display_list_create(uint16_t capacity)
+{
+    DisplayList *list = app_calloc(1, sizeof(DisplayList) + capacity * sizeof(DisplayListCommand));
+    if (list == NULL)
+    {
+        SYS_LOG("dlist", APP_LOG_LEVEL_ERROR, "NO MEMORY FOR DISPLAY LIST!");
+        return NULL;
+    }
+    list->capacity = capacity;
+    list->status = DisplayListEmpty;
+
+    return list;
+}
+
+void display_list_destroy(DisplayList *list)
+{
+    if (list == NULL)
+        return;
+
+    if (_recording == list)
+        _recording = NULL;
+    app_free(list);
+}
+
+void display_list_invalidate(DisplayList *list)
+{
+    if (list->status == DisplayListValid)
+        list->status = DisplayListEmpty;
+}
+
+bool display_list_is_valid(const DisplayList *list)
+{
+    return list->status == DisplayListValid;
+}
+
+/*
+ * Start capturing draw calls into list. Returns false if the list
+ * can't be recorded, in which case the caller just draws directly
+ */
+bool display_list_begin_record(DisplayList *list, n_GContext *ctx)
+{
+    if (_recording || list->status == DisplayListUnsupported)
+        return false;
+
+    list->count = 0;
+    _recording = list;
+    _recorded_state_valid = false;
+
+    return true;
+}
+
+void display_list_end_record(n_GContext *ctx)
+{
+    DisplayList *list = _recording;
+    if (list == NULL)
+        return;
+
+    if (list->status != DisplayListUnsupported)
+    {
+        /* the update_proc may leave state set for the layers drawn after it */
+        DisplayListCommand command = { .op = DisplayListOpState };
+        _state_from_context(&command.state, ctx);
+        if (!_recorded_state_valid ||
+            memcmp(&command.state, &_recorded_state, sizeof(DisplayListState)))
+            _append(&command);
+    }
+
+    _recording = NULL;
+
+    if (list->status == DisplayListUnsupported)
+    {
+        list->count = 0;
+        return;
+    }
+
+    list->status = DisplayListValid;
+}
+
+bool display_list_is_recording(void)
+{
+    return _recording != NULL;
+}
+
+void display_list_record(n_GContext *ctx, const DisplayListCommand *command)
+{
+    if (_recording == NULL || _recording->status == DisplayListUnsupported)
+        return;
+
+    DisplayListCommand state = { .op = DisplayListOpState };
+    _state_from_context(&state.state, ctx);
+    if (!_recorded_state_valid ||
+        memcmp(&state.state, &_recorded_state, sizeof(DisplayListState)))
+    {
+        if (!_append(&state))
+            return;
+        _recorded_state = state.state;
+        _recorded_state_valid = true;
+    }
+
+    _append(command);
+}
+
+/*
+ * The update_proc called something we can't capture (paths, raw
+ * framebuffer access, or an n_graphics_* draw that skips the wrappers).
+ * That layer always draws through its update_proc
+ */
+void display_list_abort_record(void)
+{
+    if (_recording == NULL)
+        return;
+
+    _recording->status = DisplayListUnsupported;
+}
+
+void display_list_replay(const DisplayList *list, n_GContext *ctx)
+{
+    const DisplayListCommand *command = list->commands;
+    const DisplayListCommand *end = list->commands + list->count;
+
+    for (; command < end; command++)
+    {
+        switch (command->op)
+        {
+            case DisplayListOpState:
+                ctx->stroke_color = command->state.stroke_color;
+                ctx->fill_color = command->state.fill_color;
+                ctx->text_color = command->state.text_color;
+                ctx->stroke_width = command->state.stroke_width;
+                ctx->antialias = command->state.antialias;
+                break;
+            case DisplayListOpFillRect:
+                graphics_fill_rect(ctx, command->rect.rect, command->rect.radius, command->rect.mask);
+                break;
+            case DisplayListOpDrawRect:
+                graphics_draw_rect(ctx, command->rect.rect, command->rect.radius, command->rect.mask);
+                break;
+            case DisplayListOpFillCircle:
+                graphics_fill_circle(ctx, command->circle.p, command->circle.radius);
+                break;
+            case DisplayListOpDrawCircle:
+                graphics_draw_circle(ctx, command->circle.p, command->circle.radius);
+                break;
+            case DisplayListOpDrawLine:
+                graphics_draw_line(ctx, command->line.from, command->line.to);
+                break;
+            case DisplayListOpDrawPixel:
+                graphics_draw_pixel(ctx, command->pixel.p);
+                break;
+            case DisplayListOpDrawText:
+                graphics_draw_text(ctx, command->text.text, command->text.font,
+                                   command->text.box, command->text.overflow_mode,
+                                   command->text.alignment, command->text.attributes);
+                break;
+            case DisplayListOpDrawBitmap:
+                graphics_draw_bitmap_in_rect(ctx, command->bitmap.bitmap, command->bitmap.rect);
+                break;
+        }
+    }
+}
+
+/* Private functions */
+
+static void _state_from_context(DisplayListState *state, n_GContext *ctx)
+{
+    memset(state, 0, sizeof(DisplayListState));
+    state->stroke_color = ctx->stroke_color;
+    state->fill_color = ctx->fill_color;
+    state->text_color = ctx->text_color;
+    state->stroke_width = ctx->stroke_width;
+    state->antialias = ctx->antialias;
+}
+
+static bool _append(const DisplayListCommand *command)
+{
+    DisplayList *list = _recording;
+
+    if (list->count >= list->capacity)
+    {
+        SYS_LOG("dlist", APP_LOG_LEVEL_DEBUG, "Display list full (%d), drawing directly", list->capacity);
+        list->status = DisplayListUnsupported;
+        return false;
+    }
+
+    list->commands[list->count++] = *command;
+    return true;
+}
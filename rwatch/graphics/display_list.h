@@ -0,0 +1,86 @@
+#pragma once
+/* display_list.h
+ * Record a layer's draw calls once and replay them on later frames
+ * libRebbleOS
+ */
+
+#include "librebble.h"
+
+/* Number of commands a layer's display list can hold by default.
+ * A layer that draws more than this falls back to its update_proc */
+#define DISPLAY_LIST_DEFAULT_CAPACITY 16
+
+typedef enum DisplayListOp {
+    DisplayListOpState,
+    DisplayListOpFillRect,
+    DisplayListOpDrawRect,
+    DisplayListOpFillCircle,
+    DisplayListOpDrawCircle,
+    DisplayListOpDrawLine,
+    DisplayListOpDrawPixel,
+    DisplayListOpDrawText,
+    DisplayListOpDrawBitmap,
+} DisplayListOp;
+
+/* The slice of context state that draw calls depend on.
+ * Only emitted into the list when it changes between draws */
+typedef struct DisplayListState {
+    n_GColor stroke_color;
+    n_GColor fill_color;
+    n_GColor text_color;
+    uint8_t stroke_width;
+    uint8_t antialias;
+} DisplayListState;
+
+/* Commands are recorded in layer-local coordinates, so a list survives
+ * the layer being moved by its parent. Pointers (text, font, bitmap) are
+ * kept by reference; changing what they point at needs a layer_mark_dirty */
+typedef struct DisplayListCommand {
+    uint8_t op;
+    union {
+        DisplayListState state;
+        struct {
+            n_GRect rect;
+            uint16_t radius;
+            n_GCornerMask mask;
+        } rect;
+        struct {
+            n_GPoint p;
+            uint16_t radius;
+        } circle;
+        struct {
+            n_GPoint p;
+        } pixel;
+        struct {
+            n_GPoint from;
+            n_GPoint to;
+        } line;
+        struct {
+            n_GRect box;
+            const char *text;
+            n_GFont font;
+            n_GTextAttributes *attributes;
+            uint8_t overflow_mode;
+            uint8_t alignment;
+        } text;
+        struct {
+            n_GRect rect;
+            GBitmap *bitmap;
+        } bitmap;
+    };
+} DisplayListCommand;
+
+typedef struct DisplayList DisplayList;
+
+DisplayList *display_list_create(uint16_t capacity);
+void display_list_destroy(DisplayList *list);
+void display_list_invalidate(DisplayList *list);
+bool display_list_is_valid(const DisplayList *list);
+
+bool display_list_begin_record(DisplayList *list, n_GContext *ctx);
+void display_list_end_record(n_GContext *ctx);
+bool display_list_is_recording(void);
+void display_list_record(n_GContext *ctx, const DisplayListCommand *command);
+void display_list_abort_record(void);
+
+void display_list_replay(const DisplayList *list, n_GContext *ctx);
@@ -14,6 +14,13 @@
 extern uint8_t *resource_fully_load_id_app(uint16_t, const struct file *file);
 
 void _gbitmap_draw(GBitmap *bitmap, GRect clip);
+static bool _gbitmap_resource_is_native(ResHandle res_handle, const struct file *file, GBitmapNativeHeader *header);
+static GBitmap *_gbitmap_create_native(ResHandle res_handle, const struct file *file, GBitmapNativeHeader *header);
+static uint8_t *_gbitmap_alloc_data(GBitmap *bitmap, size_t size);
+static void _gbitmap_move_data(GBitmap *bitmap);
+static void _gbitmap_lock_data(GBitmap *bitmap);
+static void _gbitmap_unlock_data(GBitmap *bitmap);
+static void _gbitmap_release_handle(GBitmap *bitmap);
 
 /*
  * Create a bitmap of size frame
@@ -40,7 +47,9 @@ void gbitmap_destroy(GBitmap *bitmap)
     
     if (bitmap->free_palette_on_destroy)
         app_free(bitmap->palette);
-    if (bitmap->free_data_on_destroy)
+    if (bitmap->data_handle)
+        _gbitmap_release_handle(bitmap);
+    else if (bitmap->free_data_on_destroy)
         app_free(bitmap->addr);
         
     app_free(bitmap);
@@ -54,7 +63,9 @@ void gbitmap_destroy(GBitmap *bitmap)
  */
 void gbitmap_draw(GBitmap *bitmap, GRect bounds)
 {
+    _gbitmap_lock_data(bitmap);
     _gbitmap_draw(bitmap, bounds);
+    _gbitmap_unlock_data(bitmap);
 }
 
 /*
@@ -214,6 +225,16 @@ GBitmapFormat gbitmap_get_format(const GBitmap *bitmap)
  */
 uint8_t *gbitmap_get_data(const GBitmap *bitmap)
 {
+    GBitmap *b = (GBitmap *)bitmap;
+    
+    /* the caller can hang on to this, so it must not move again until
+     * the data is replaced or the bitmap goes */
+    if (b->data_handle && !b->data_pinned)
+    {
+        _gbitmap_lock_data(b);
+        b->data_pinned = true;
+    }
+    
     return (uint8_t *)bitmap->addr;
 }
 
@@ -222,6 +243,8 @@ uint8_t *gbitmap_get_data(const GBitmap *bitmap)
  */
 void gbitmap_set_data(GBitmap *bitmap, uint8_t *data, GBitmapFormat format, uint16_t row_size_bytes, bool free_on_destroy)
 {
+    _gbitmap_release_handle(bitmap);
+    
     bitmap->addr = data;
     bitmap->format = format;
     bitmap->row_size_bytes = row_size_bytes;
@@ -257,7 +280,9 @@ GColor *gbitmap_get_palette(const GBitmap *bitmap)
  */
 void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy)
 {
-    app_free(bitmap->palette);
+    /* native bitmaps carry their palette inside the data buffer */
+    if (bitmap->free_palette_on_destroy)
+        app_free(bitmap->palette);
     bitmap->palette = palette;
     bitmap->free_palette_on_destroy = free_on_destroy;
 }
@@ -267,8 +292,14 @@ void gbitmap_set_palette(GBitmap *bitmap, GColor *palette, bool free_on_destroy)
  */
 GBitmap *gbitmap_create_with_resource(uint32_t resource_id)
 {
-    uint8_t *png_data = resource_fully_load_id_system(resource_id);
+    GBitmapNativeHeader header;
     ResHandle res_handle = resource_get_handle_system(resource_id);
+    
+    /* Pre-converted by mkpack? Then there is nothing to decode */
+    if (_gbitmap_resource_is_native(res_handle, NULL, &header))
+        return _gbitmap_create_native(res_handle, NULL, &header);
+    
+    uint8_t *png_data = resource_fully_load_res_system(res_handle);
     size_t png_data_size = resource_size(res_handle);
     
     if (!png_data)
@@ -279,8 +310,13 @@ GBitmap *gbitmap_create_with_resource(uint32_t resource_id)
 
 GBitmap *gbitmap_create_with_resource_app(uint32_t resource_id, const struct file *file)
 {
-    uint8_t *png_data = (uint8_t*)resource_fully_load_id_app(resource_id, file);
+    GBitmapNativeHeader header;
     ResHandle res_handle = resource_get_handle_app(resource_id, file);
+    
+    if (_gbitmap_resource_is_native(res_handle, file, &header))
+        return _gbitmap_create_native(res_handle, file, &header);
+    
+    uint8_t *png_data = resource_fully_load_res_app(res_handle, file);
     size_t png_data_size = resource_size(res_handle);
     
     if (!png_data)
@@ -289,6 +325,156 @@ GBitmap *gbitmap_create_with_resource_app(uint32_t resource_id, const struct fil
     return gbitmap_create_from_png_data(png_data, png_data_size);
 }
 
+/*
+ * Peek at the start of a resource to see if it was converted to the
+ * native bitmap format at build time. file is NULL for system resources
+ */
+static bool _gbitmap_resource_is_native(ResHandle res_handle, const struct file *file, GBitmapNativeHeader *header)
+{
+    if (resource_size(res_handle) < sizeof(GBitmapNativeHeader))
+        return false;
+    
+    if (file)
+        resource_load_app_partial(res_handle, (uint8_t *)header, 0, sizeof(GBitmapNativeHeader), file);
+    else
+        resource_load_system_partial(res_handle, (uint8_t *)header, 0, sizeof(GBitmapNativeHeader));
+    
+    return memcmp(header->magic, GBITMAP_NATIVE_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == GBITMAP_NATIVE_VERSION;
+}
+
+/*
+ * Create a bitmap from a native resource. The pixels and palette are read
+ * from flash straight into their buffers. No decode, no intermediate copy
+ * of the compressed data.
+ */
+static GBitmap *_gbitmap_create_native(ResHandle res_handle, const struct file *file, GBitmapNativeHeader *header)
+{
+    size_t data_size = header->row_size_bytes * header->height;
+    size_t palette_bytes = header->palette_size * sizeof(n_GColor);
+    
+    /* GBitmap can't hold a bigger palette; mkpack writes those as GColor8 */
+    if (header->palette_size > UINT8_MAX)
+    {
+        SYS_LOG("gbitmap", APP_LOG_LEVEL_ERROR, "Native bitmap res %d has a %d colour palette",
+                res_handle.index, header->palette_size);
+        return NULL;
+    }
+    
+    if (sizeof(GBitmapNativeHeader) + data_size + palette_bytes > resource_size(res_handle))
+    {
+        SYS_LOG("gbitmap", APP_LOG_LEVEL_ERROR, "Native bitmap res %d is truncated", res_handle.index);
+        return NULL;
+    }
+    
+    GBitmap *bitmap = gbitmap_create(GRect(0, 0, header->width, header->height));
+    if (bitmap == NULL)
+        return NULL;
+    
+    /* the pixels are the big part, and long lived, so they go in a
+     * movable block. The palette is small enough to stay put */
+    uint8_t *pixels = _gbitmap_alloc_data(bitmap, data_size);
+    n_GColor *palette = palette_bytes ? app_calloc(1, palette_bytes) : NULL;
+    bitmap->palette = palette;
+    if (pixels == NULL || (palette_bytes && palette == NULL))
+    {
+        SYS_LOG("gbitmap", APP_LOG_LEVEL_ERROR, "Native bitmap alloc of %d bytes failed", data_size + palette_bytes);
+        _gbitmap_unlock_data(bitmap);
+        gbitmap_destroy(bitmap);
+        return NULL;
+    }
+    
+    if (file)
+    {
+        resource_load_app_partial(res_handle, pixels, sizeof(GBitmapNativeHeader), data_size, file);
+        if (palette)
+            resource_load_app_partial(res_handle, (uint8_t *)palette,
+                                      sizeof(GBitmapNativeHeader) + data_size, palette_bytes, file);
+    }
+    else
+    {
+        resource_load_system_partial(res_handle, pixels, sizeof(GBitmapNativeHeader), data_size);
+        if (palette)
+            resource_load_system_partial(res_handle, (uint8_t *)palette,
+                                         sizeof(GBitmapNativeHeader) + data_size, palette_bytes);
+    }
+    _gbitmap_unlock_data(bitmap);
+
+    bitmap->format = header->format;
+    bitmap->row_size_bytes = header->row_size_bytes;
+    bitmap->raw_bitmap_size.w = header->width;
+    bitmap->raw_bitmap_size.h = header->height;
+    bitmap->palette_size = header->palette_size;
+    
+    return bitmap;
+}
+
+/*
+ * Give a new bitmap its pixel buffer, in a movable block if we can get
+ * one so the heap can be compacted around it. Comes back locked
+ */
+static uint8_t *_gbitmap_alloc_data(GBitmap *bitmap, size_t size)
+{
+    bitmap->data_handle = app_handle_alloc(size);
+    if (bitmap->data_handle)
+        bitmap->addr = app_handle_lock(bitmap->data_handle);
+    else
+        bitmap->addr = app_calloc(1, size);
+    
+    return bitmap->addr;
+}
+
+/*
+ * upng hands us its own fixed buffer. If there is room, swap it for a
+ * movable one so this bitmap doesn't pin the heap for its whole life
+ */
+static void _gbitmap_move_data(GBitmap *bitmap)
+{
+    if (bitmap->addr == NULL || bitmap->data_handle || !bitmap->free_data_on_destroy)
+        return;
+    
+    size_t size = bitmap->row_size_bytes * bitmap->raw_bitmap_size.h;
+    app_handle_t handle = app_handle_alloc(size);
+    if (handle == NULL)
+        return;
+    
+    uint8_t *old = bitmap->addr;
+    bitmap->addr = app_handle_lock(handle);
+    memcpy(bitmap->addr, old, size);
+    app_handle_unlock(handle);
+    app_free(old);
+    bitmap->data_handle = handle;
+}
+
+static void _gbitmap_lock_data(GBitmap *bitmap)
+{
+    if (bitmap->data_handle)
+        bitmap->addr = app_handle_lock(bitmap->data_handle);
+}
+
+static void _gbitmap_unlock_data(GBitmap *bitmap)
+{
+    if (bitmap->data_handle)
+        app_handle_unlock(bitmap->data_handle);
+}
+
+/*
+ * Let go of the movable block: drop any pin, and free it if it is ours
+ */
+static void _gbitmap_release_handle(GBitmap *bitmap)
+{
+    if (bitmap->data_handle == NULL)
+        return;
+    
+    if (bitmap->data_pinned)
+        app_handle_unlock(bitmap->data_handle);
+    if (bitmap->free_data_on_destroy)
+        app_handle_free(bitmap->data_handle);
+    
+    bitmap->data_handle = NULL;
+    bitmap->data_pinned = false;
+}
+
 /*
  * Create a new bitmap with the given data
  */
@@ -310,12 +496,15 @@ GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect
 {
     GBitmap *bitmap = gbitmap_create(sub_rect);
     bitmap->addr = base_bitmap->addr;
+    bitmap->data_handle = base_bitmap->data_handle;
+    bitmap->data_pinned = false;
     bitmap->raw_bitmap_size = base_bitmap->raw_bitmap_size;
     bitmap->palette = base_bitmap->palette;
     bitmap->palette_size = base_bitmap->palette_size;
     bitmap->row_size_bytes = base_bitmap->row_size_bytes;
-    bitmap->free_palette_on_destroy = base_bitmap->free_palette_on_destroy;
-    bitmap->free_data_on_destroy = base_bitmap->free_data_on_destroy;
+    /* the parent owns the pixels and palette, we only borrow them */
+    bitmap->free_palette_on_destroy = false;
+    bitmap->free_data_on_destroy = false;
     bitmap->format = base_bitmap->format;
     bitmap->bounds = sub_rect;
  
@@ -334,6 +523,7 @@ GBitmap *gbitmap_create_from_png_data(uint8_t *png_data, size_t png_data_size)
     GBitmap *bitmap = gbitmap_create(fr);
 
     png_to_gbitmap(bitmap, png_data, png_data_size);
+    _gbitmap_move_data(bitmap);
     
     return bitmap;
 }
@@ -346,13 +536,14 @@ GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format)
     GRect gr = { .size = size, .origin.x = 0, .origin.y = 0 };
     GBitmap *bitmap = gbitmap_create(gr);
     bitmap->format = format;
-    bitmap->addr = app_calloc(1, size.w * size.h);
     
-    if (bitmap->addr == NULL)
+    if (_gbitmap_alloc_data(bitmap, size.w * size.h) == NULL)
     {
         SYS_LOG("gbitmap", APP_LOG_LEVEL_ERROR, "gbitmap_create_blank Malloc failed");
         return NULL;
     }
+    _gbitmap_unlock_data(bitmap);
+    
     return bitmap;
 }
 
@@ -10,6 +10,7 @@
 #include "pebble_defines.h"
 #include "color.h"
 #include "upng.h"
+#include "rebble_memory.h"
 
 struct file;
 
@@ -56,8 +57,34 @@ typedef struct GBitmap
     bool free_data_on_destroy; // TODo move me to a bit status register above for size
     n_GRect bounds;
     GBitmapFormat format;
+    /* If set, the pixels are in a movable block and addr is only good
+     * while it is locked. gbitmap_get_data pins the block, as the SDK has
+     * no call to hand the pointer back; the pin lasts until the data is
+     * replaced or the bitmap destroyed. Sub-bitmaps share their parent's
+     * handle but never own it */
+    app_handle_t data_handle;
+    bool data_pinned;
 } GBitmap;
 
+/* Bitmap resources that mkpack has already converted to our native format
+ * (see convert_png_to_gbitmap in Utilities/mkpack.py) start with this
+ * header, and are followed by the pixel data and then the palette.
+ * The magic is what tells the loader to skip the PNG decoder. */
+#define GBITMAP_NATIVE_MAGIC   "RBMP"
+#define GBITMAP_NATIVE_VERSION 1
+
+typedef struct GBitmapNativeHeader
+{
+    char magic[4];
+    uint8_t version;
+    uint8_t format;           // GBitmapFormat
+    uint16_t row_size_bytes;  // padded to a word
+    uint16_t width;
+    uint16_t height;
+    uint16_t palette_size;    // count of GColor8 entries after the pixels
+    uint16_t reserved;
+} __attribute__((__packed__)) GBitmapNativeHeader;
+
 
 
 bool gcolor_equal(GColor8 x, GColor8 y);
@@ -9,6 +9,7 @@
 #include "upng.h"
 #include "png.h"
 #include "graphics_wrapper.h"
+#include "display_list.h"
 
 extern void r_graphics_draw_bitmap_in_rect(GContext *ctx, GBitmap *bitmap, GRect rect);
 
@@ -36,21 +37,33 @@ n_GPoint _jimmy_layer_point_offset(n_GContext *ctx, n_GPoint point)
 // void n_graphics_fill_rect_app(n_GContext * ctx, n_GRect rect, uint16_t radius, n_GCornerMask mask);
 void graphics_fill_rect(n_GContext * ctx, n_GRect rect, uint16_t radius, n_GCornerMask mask)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpFillRect, .rect = { rect, radius, mask } });
     n_graphics_fill_rect(ctx, _jimmy_layer_offset(ctx, rect), radius, mask);
 }
 
 void graphics_fill_circle(n_GContext * ctx, n_GPoint p, uint16_t radius)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpFillCircle, .circle = { p, radius } });
     n_graphics_fill_circle(ctx, _jimmy_layer_point_offset(ctx, p), radius);
 }
 
 void graphics_draw_circle(n_GContext * ctx, n_GPoint p, uint16_t radius)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawCircle, .circle = { p, radius } });
     n_graphics_draw_circle(ctx, _jimmy_layer_point_offset(ctx, p), radius);
 }
 
 void graphics_draw_line(n_GContext * ctx, n_GPoint from, n_GPoint to)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawLine, .line = { from, to } });
     n_graphics_draw_line(ctx, 
                          _jimmy_layer_point_offset(ctx, from), 
                          _jimmy_layer_point_offset(ctx, to));
@@ -61,6 +74,10 @@ void graphics_draw_text(
     const n_GTextOverflowMode overflow_mode, const n_GTextAlignment alignment,
     n_GTextAttributes * text_attributes)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawText,
+            .text = { box, text, font, text_attributes, overflow_mode, alignment } });
     n_graphics_draw_text(ctx, text, font, _jimmy_layer_offset(ctx, box),
                             overflow_mode, alignment,
                             text_attributes);
@@ -68,18 +85,27 @@ void graphics_draw_text(
 
 void graphics_draw_bitmap_in_rect(GContext *ctx, GBitmap *bitmap, GRect rect)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawBitmap, .bitmap = { rect, bitmap } });
     r_graphics_draw_bitmap_in_rect(ctx, bitmap, _jimmy_layer_offset(ctx, rect));
 }
 
 
 void graphics_draw_pixel(n_GContext * ctx, n_GPoint p)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawPixel, .pixel = { p } });
     n_graphics_draw_pixel(ctx, _jimmy_layer_point_offset(ctx, p));
 
 }
 
 void graphics_draw_rect(n_GContext * ctx, n_GRect rect, uint16_t radius, n_GCornerMask mask)
 {
+    if (display_list_is_recording())
+        display_list_record(ctx, &(DisplayListCommand) {
+            .op = DisplayListOpDrawRect, .rect = { rect, radius, mask } });
     n_graphics_draw_rect(ctx, _jimmy_layer_offset(ctx, rect), radius, mask);
 }
 
@@ -89,6 +115,7 @@ GBitmap *graphics_capture_frame_buffer(n_GContext *context)
 {
     // TODO Honestly not entirely sure what is expected here
     // rbl_lock_frame_buffer
+    display_list_abort_record();
     return (GBitmap *)display_get_buffer();
 }
 
@@ -96,6 +123,7 @@ GBitmap *graphics_capture_frame_buffer_format(n_GContext *context, GBitmap forma
 {
     // TODO Honestly not entirely sure what is expected here
     // rbl_lock_frame_buffer
+    display_list_abort_record();
     return (GBitmap *)display_get_buffer();
 }
 
@@ -107,6 +135,7 @@ void graphics_release_frame_buffer(n_GContext *context, GBitmap *bitmap)
 
 void gpath_fill_app(n_GContext * ctx, n_GPath * path)
 {
+    display_list_abort_record();
     GPoint off = path->offset;
     GPoint r = _jimmy_layer_point_offset(ctx, path->offset);
     path->offset.x = r.x;
@@ -118,6 +147,7 @@ void gpath_fill_app(n_GContext * ctx, n_GPath * path)
 
 void gpath_draw_app(n_GContext * ctx, n_GPath * path)
 {
+    display_list_abort_record();
     GPoint off = path->offset;
     GPoint r = _jimmy_layer_point_offset(ctx, path->offset);
     path->offset.x = r.x;
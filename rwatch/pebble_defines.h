@@ -43,6 +43,7 @@
 #define GTextAlignmentCenter n_GTextAlignmentCenter
 #define GTextAlignmentRight n_GTextAlignmentRight
 #define GTextAttributes n_GTextAttributes
+#define graphics_text_layout_get_content_size n_graphics_text_layout_get_content_size
 
 
 // math
@@ -11,6 +11,7 @@
 #include "rebbleos.h"
 #include "action_menu.h"
 #include "menu_layer.h"
+#include "display_list.h"
 #include "pebble_defines.h"
 
 #define ACTION_MENU_SIDEBAR_SIZE        PBL_IF_RECT_ELSE(14, 11)
@@ -159,6 +160,7 @@ static void _side_bar_update_proc(Layer *layer, GContext *nGContext)
     graphics_fill_rect(nGContext, GRect(0, 0, layer->frame.size.w, layer->frame.size.h), 0, GCornerNone);
     
     graphics_context_set_fill_color(nGContext, config->colors.foreground);
+    display_list_abort_record();
     for (int i = 0; i <= action_menu->level_index; i++) {
         n_graphics_fill_circle(nGContext, GPoint(layer->frame.size.w / 2, 8 * (i + 1) + 2), 2);
     }
@@ -166,6 +168,7 @@ static void _side_bar_update_proc(Layer *layer, GContext *nGContext)
     // On round, just draw a circle around the menu
     graphics_context_set_stroke_color(nGContext, config->colors.background);
     nGContext->stroke_width = 13;
+    display_list_abort_record();
     n_graphics_draw_circle(nGContext, GPoint(DISPLAY_COLS / 2, DISPLAY_ROWS / 2), (DISPLAY_COLS / 2) - 5);
 #endif
 }
@@ -30,7 +30,7 @@ Animation *animation_create()
 {
     SYS_LOG("animation", APP_LOG_LEVEL_INFO, "animation_create");
     
-    Animation *anim = app_calloc(1, sizeof(Animation));
+    Animation *anim = app_pool_calloc(AppPoolAnimation, sizeof(Animation));
     animation_ctor(anim);
     
     return anim;
@@ -46,11 +46,16 @@ bool animation_destroy(Animation *anim)
         return false;
     
     animation_dtor(anim);
-    app_free(anim);
+    app_pool_free(AppPoolAnimation, anim);
     
     return true;
 }
 
+bool animation_pool_reserve(uint16_t count)
+{
+    return app_pool_reserve(AppPoolAnimation, sizeof(Animation), count);
+}
+
 void animation_dtor(Animation* animation)
 {
 }
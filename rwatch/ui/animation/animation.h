@@ -78,6 +78,7 @@ typedef struct AnimationHandler
 Animation *animation_create();
 void animation_ctor(Animation* animation);
 bool animation_destroy(Animation *animation);
+bool animation_pool_reserve(uint16_t count);
 void animation_dtor(Animation* animation);
 Animation *animation_clone(Animation *from);
 Animation *animation_sequence_create(Animation *animation_a, Animation *animation_b, Animation *animation_c, ...);
@@ -124,7 +124,7 @@ PropertyAnimation * property_animation_create(const PropertyAnimationImplementat
 {
     SYS_LOG("property_animation", APP_LOG_LEVEL_INFO, "property_animation_create");
     
-    PropertyAnimation *property_animation = app_calloc(1, sizeof(PropertyAnimation));
+    PropertyAnimation *property_animation = app_pool_calloc(AppPoolPropertyAnimation, sizeof(PropertyAnimation));
     animation_ctor(&property_animation->animation);
     
     property_animation->animation.impl = implementation->base;
@@ -146,7 +146,12 @@ Animation * property_animation_get_animation(PropertyAnimation * property_animat
 void property_animation_destroy(PropertyAnimation *property_animation)
 {
     animation_dtor(&property_animation->animation);
-    app_free(property_animation);
+    app_pool_free(AppPoolPropertyAnimation, property_animation);
+}
+
+bool property_animation_pool_reserve(uint16_t count)
+{
+    return app_pool_reserve(AppPoolPropertyAnimation, sizeof(PropertyAnimation), count);
 }
 
 /*
@@ -72,6 +72,7 @@ PropertyAnimation * property_animation_create_layer_frame(struct Layer * layer,
 PropertyAnimation * property_animation_create_bounds_origin(struct Layer * layer, GPoint * from, GPoint * to);
 PropertyAnimation * property_animation_create(const PropertyAnimationImplementation * implementation, void * subject, void * from_value, void * to_value);
 void property_animation_destroy(PropertyAnimation *property_animation);
+bool property_animation_pool_reserve(uint16_t count);
 void property_animation_update_int16(PropertyAnimation * property_animation, const uint32_t distance_normalized);
 void property_animation_update_uint32(PropertyAnimation * property_animation, const uint32_t distance_normalized);
 void property_animation_update_gpoint(PropertyAnimation * property_animation, const uint32_t distance_normalized);
@@ -9,6 +9,7 @@
 #include "utils.h"
 #include "action_bar_layer.h"
 #include "bitmap_layer.h"
+#include "display_list.h"
 
 ActionBarLayer *action_bar_layer_create()
 {
@@ -23,13 +24,14 @@ ActionBarLayer *action_bar_layer_create()
     action_bar->context = action_bar;
     
     layer_set_update_proc(layer, draw);
+    layer_set_display_list_enabled(layer, true);
     
     return action_bar;
 }
 
 void action_bar_layer_destroy(ActionBarLayer *action_bar)
 {
-    layer_destroy(action_bar);
+    layer_destroy(action_bar->layer);
     
     app_free(action_bar);
 }
@@ -52,6 +54,7 @@ void action_bar_layer_set_click_config_provider(ActionBarLayer *action_bar, Clic
 void action_bar_layer_set_icon(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon)
 {
     action_bar->icons[button_id] = icon;
+    layer_mark_dirty(action_bar->layer);
 }
 
 void action_bar_layer_set_icon_animated(ActionBarLayer *action_bar, ButtonId button_id, const GBitmap *icon, bool animated)
@@ -73,6 +76,7 @@ void action_bar_layer_add_to_window(ActionBarLayer *action_bar, struct Window *w
     
     GRect bounds = layer_get_unobstructed_bounds(window_layer);
     action_bar->layer->frame = GRect(bounds.size.w - ACTION_BAR_WIDTH, 0, ACTION_BAR_WIDTH, bounds.size.h);
+    layer_mark_dirty(action_bar->layer);
 }
 
 void action_bar_layer_remove_from_window(ActionBarLayer *action_bar)
@@ -83,6 +87,7 @@ void action_bar_layer_remove_from_window(ActionBarLayer *action_bar)
 void action_bar_layer_set_background_color(ActionBarLayer *action_bar, GColor background_color)
 {
     action_bar->background_color = background_color;
+    layer_mark_dirty(action_bar->layer);
 }
 
 void action_bar_layer_set_icon_press_animation(ActionBarLayer *action_bar, ButtonId button_id, ActionBarLayerIconPressAnimation animation)
@@ -102,6 +107,7 @@ static void draw(Layer *layer, GContext *context)
 #ifdef PBL_RECT
     graphics_fill_rect(context, full_bounds, 0, GCornerNone);
 #else
+    display_list_abort_record();
     n_graphics_fill_circle(context, GPoint(full_bounds.origin.x + DISPLAY_COLS + 7, full_bounds.origin.y + (DISPLAY_COLS / 2)), DISPLAY_COLS + 20);
 #endif
     
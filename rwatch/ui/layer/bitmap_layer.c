@@ -8,6 +8,7 @@
 #include "librebble.h"
 #include "upng.h"
 #include "png.h"
+#include "display_list.h"
 
 
 static void _bitmap_update_proc(Layer *layer, GContext *nGContext);
@@ -138,5 +139,6 @@ static void _bitmap_update_proc(Layer *layer, GContext *nGContext)
     graphics_context_set_fill_color(nGContext, bitmap_layer->background);
     graphics_fill_rect(nGContext, layer->bounds, 0, GCornerNone);
     
+    display_list_abort_record();
     gbitmap_draw(bitmap_layer->bitmap, layer->bounds);
 }
@@ -7,17 +7,19 @@
 
 #include "librebble.h"
 #include "utils.h"
+#include "display_list.h"
 
 static void _layer_remove_node(Layer *to_be_removed);
 static void _layer_insert_node(Layer *layer_to_insert, Layer *sibling_layer, bool below);
 static void _layer_delete_tree(Layer *layer);
 static Layer *_layer_find_parent(Layer *orig_layer, Layer *layer);
 static void _layer_walk(const Layer *layer, GContext *context);
+static void _layer_draw_self(const Layer *layer, GContext *context);
 
 // Layer Functions
 Layer *layer_create(GRect frame)
 {
-    Layer* layer = app_calloc(1, sizeof(Layer));
+    Layer* layer = app_pool_calloc(AppPoolLayer, sizeof(Layer));
     if (layer == NULL)
     {
         SYS_LOG("layer", APP_LOG_LEVEL_ERROR, "NO MEMORY FOR LAYER!");
@@ -43,11 +45,18 @@ void layer_ctor(Layer* layer, GRect frame)
     layer->child = NULL;
     layer->sibling = NULL;
     layer->parent = NULL;
+    layer->display_list = NULL;
 }
 
 void layer_destroy(Layer* layer)
 {
     layer_dtor(layer);
+    app_pool_free(AppPoolLayer, layer);
+}
+
+bool layer_pool_reserve(uint16_t count)
+{
+    return app_pool_reserve(AppPoolLayer, sizeof(Layer), count);
 }
 
 void layer_dtor(Layer *layer)
@@ -55,6 +64,7 @@ void layer_dtor(Layer *layer)
     // remove our node
     SYS_LOG("layer", APP_LOG_LEVEL_ERROR, "Layer DTOR");
     _layer_remove_node(layer);
+    layer_set_display_list_enabled(layer, false);
     // free the children too...
     /* @ginge Actually, Pebble doesn't do this so we dont either */
     /*_layer_delete_tree(layer);
@@ -69,6 +79,8 @@ GRect layer_get_unobstructed_bounds(Layer *layer)
 void layer_set_update_proc(Layer *layer, void *proc)
 {
     layer->update_proc = proc;
+    if (layer->display_list)
+        display_list_invalidate(layer->display_list);
 }
 
 void layer_add_child(Layer *parent_layer, Layer *child_layer)
@@ -115,6 +127,8 @@ void layer_add_child(Layer *parent_layer, Layer *child_layer)
 void layer_mark_dirty(Layer *layer)
 {
     //layer->window
+    if (layer->display_list)
+        display_list_invalidate(layer->display_list);
     window_dirty(true);
 }
 
@@ -208,6 +222,19 @@ void layer_draw(const Layer *layer, GContext *context)
     _layer_walk(layer, context);
 }
 
+void layer_set_display_list_enabled(Layer *layer, bool enabled)
+{
+    if (enabled && layer->display_list == NULL)
+    {
+        layer->display_list = display_list_create(DISPLAY_LIST_DEFAULT_CAPACITY);
+    }
+    else if (!enabled && layer->display_list)
+    {
+        display_list_destroy(layer->display_list);
+        layer->display_list = NULL;
+    }
+}
+
 void layer_apply_frame_offset(const Layer *layer, GContext *context)
 {
     context->offset.origin.x += layer->frame.origin.x;
@@ -283,7 +310,7 @@ static void _layer_walk(const Layer *layer, GContext *context)
             layer_apply_frame_offset(layer, context);
 
             if (layer->update_proc)
-                layer->update_proc((Layer *)layer, context);
+                _layer_draw_self(layer, context);
 
             // walk this elements sub elements recursively before moving on to the next element
             _layer_walk(layer->child, context);
@@ -294,6 +321,30 @@ static void _layer_walk(const Layer *layer, GContext *context)
     }
 }
 
+/*
+ * Draw just this layer. If it has a display list we replay that,
+ * otherwise run the update_proc, recording it on the way if we can
+ */
+static void _layer_draw_self(const Layer *layer, GContext *context)
+{
+    DisplayList *list = layer->display_list;
+
+    if (list && display_list_is_valid(list))
+    {
+        display_list_replay(list, context);
+        return;
+    }
+
+    if (list && display_list_begin_record(list, context))
+    {
+        layer->update_proc((Layer *)layer, context);
+        display_list_end_record(context);
+        return;
+    }
+
+    layer->update_proc((Layer *)layer, context);
+}
+
 static Layer *_layer_find_parent(Layer *orig_layer, Layer *layer)
 {
     if (layer)
@@ -340,7 +391,7 @@ static void _layer_delete_tree(Layer *layer)
             inj--;
         }
         SYS_LOG("test", APP_LOG_LEVEL_DEBUG, "DTREE %s    DONE %d", sinj, layer);
-        app_free(layer);
+        app_pool_free(AppPoolLayer, layer);
     }
 }
 
@@ -12,6 +12,7 @@
 
 struct Window;
 struct Layer;
+struct DisplayList;
 
 // Callback for the layer drawing
 // typedef it for cleanness
@@ -30,6 +31,7 @@ typedef struct Layer
     LayerUpdateProc update_proc;
     void *callback_data;
     bool hidden;
+    struct DisplayList *display_list; // recorded draw calls, if enabled
 } Layer;
 
 
@@ -41,6 +43,7 @@ void layer_dtor(Layer* layer);
 Layer *layer_create(GRect bounds);
 Layer *layer_create_with_data(GRect frame, size_t data_size);
 void layer_destroy(Layer *layer);
+bool layer_pool_reserve(uint16_t count);
 
 void layer_set_frame(Layer *layer, GRect frame);
 GRect layer_get_frame(const Layer *layer);
@@ -68,4 +71,7 @@ void *layer_get_data(const Layer *layer); //TODO
 void layer_draw(const Layer *layer, GContext *context);
 // updates context offset based on layer frame, used to properly adjust layer drawing calls
 void layer_apply_frame_offset(const Layer *layer, GContext *context);
+// record the update_proc's draw calls and replay them until the layer is marked dirty
+// Not in the original API. Only for layers whose update_proc draws through graphics_*
+void layer_set_display_list_enabled(Layer *layer, bool enabled);
 
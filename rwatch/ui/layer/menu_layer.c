@@ -124,16 +124,67 @@ void menu_layer_set_selected_next(MenuLayer *menu_layer, bool up, MenuRowAlign s
     menu_layer_set_selected_index(menu_layer, get_next_index(menu_layer, up), scroll_align, animated);
 }
 
+/*
+ * Order a cell against a row index. Cells are stored in index order:
+ * each section's header (if any) first, then its rows
+ */
+static int16_t _cell_compare(const MenuCellSpan *span, const MenuIndex *index)
+{
+    if (span->index.section != index->section)
+        return span->index.section - index->section;
+    if (span->header)
+        return -1;
+    return span->index.row - index->row;
+}
+
 static MenuCellSpan *_get_cell_span(MenuLayer *menu_layer, const MenuIndex *index)
 {
-    // TODO: optimize, binary search should be enough
-    for (size_t cell = 0; cell < menu_layer->cells_count; ++cell)
-        if (menu_index_compare(index, &menu_layer->cells[cell].index) == 0 && !menu_layer->cells[cell].header)
-            return &menu_layer->cells[cell];
+    size_t lo = 0;
+    size_t hi = menu_layer->cells_count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int16_t cmp = _cell_compare(&menu_layer->cells[mid], index);
+
+        if (cmp == 0)
+            return &menu_layer->cells[mid];
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
     return NULL;
 }
 
+/*
+ * Find the first cell that reaches below y. Cells are laid out top to
+ * bottom so their y offsets are already a cumulative index; binary search
+ * for the first cell starting below y, then step back over the (at most
+ * one row of) cells that start above y but overlap it
+ */
+static size_t _get_first_visible_cell(MenuLayer *menu_layer, int16_t y)
+{
+    size_t lo = 0;
+    size_t hi = menu_layer->cells_count;
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (menu_layer->cells[mid].y <= y)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    while (lo > 0 && menu_layer->cells[lo - 1].y + menu_layer->cells[lo - 1].h > y)
+        lo--;
+
+    return lo;
+}
+
 static int16_t _get_aligned_edge_position(int16_t height, MenuRowAlign align)
 {
     switch (align)
@@ -475,10 +526,14 @@ static void menu_layer_update_proc(Layer *layer, GContext *nGContext)
         graphics_fill_rect(nGContext, frame, 0, GCornerNone);
     }
 
-    // Draw cells
-    for (size_t cell = 0; cell < menu_layer->cells_count; ++cell)
+    // Draw cells, only those that intersect the visible part of the scroll layer
+    int16_t visible_top = -scroll_layer_get_content_offset(&menu_layer->scroll_layer).y - frame.origin.y;
+    int16_t visible_bottom = visible_top + layer_get_frame(&menu_layer->scroll_layer.layer).size.h;
+
+    for (size_t cell = _get_first_visible_cell(menu_layer, visible_top);
+         cell < menu_layer->cells_count && menu_layer->cells[cell].y < visible_bottom;
+         ++cell)
     {
-        // TODO: only draw visible cells based on layer frame/bounds
         MenuCellSpan *span = menu_layer->cells + cell;
         layer->callback_data = span;
         layer->frame = GRect(span->x, span->y, (span->header ? frame.size.w : cell_width), span->h);
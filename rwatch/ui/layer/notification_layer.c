@@ -12,6 +12,7 @@
 #include "property_animation.h"
 #include "librebble.h"
 #include "ngfxwrap.h"
+#include "display_list.h"
 
 static void _notification_layer_load(Window *window);
 static void _notification_layer_unload(Window *window);
@@ -346,6 +347,7 @@ static void _notification_layer_update_proc(Layer *layer, GContext *ctx)
     GRect rect_bounds = GRect(0, 0 - offset, bounds.size.w, 35);
     graphics_fill_rect(ctx, rect_bounds, 0, GCornerNone);
 #else
+    display_list_abort_record();
     n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS / 2, (-DISPLAY_COLS + 35) - offset), DISPLAY_COLS);
 #endif
     
@@ -394,6 +396,7 @@ static void _notification_layer_update_proc(Layer *layer, GContext *ctx)
     
     // Draw the indicator:
     graphics_context_set_fill_color(ctx, GColorBlack);
+    display_list_abort_record();
     n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS + 2, DISPLAY_ROWS / 2), 10);
     
     // And the other one:
@@ -402,6 +405,7 @@ static void _notification_layer_update_proc(Layer *layer, GContext *ctx)
     {
         Notification *n = list_elem(notification->node.next, Notification, node);
         graphics_context_set_fill_color(ctx, n->color);
+        display_list_abort_record();
         n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS / 2, DISPLAY_ROWS - 2), 10);
     }
 #endif
@@ -1,5 +1,5 @@
-/* action_bar_layer.c
- * routines for [...]
+/* status_bar_layer.c
+ * A bar showing the time or a line of text along the top of a window
  * libRebbleOS
  *
  * Author: Carson Katri <me@carsonkatri.com>
@@ -9,6 +9,8 @@
 #include "text.h"
 
 void text_layer_draw(struct Layer *layer, GContext *context);
+static bool _text_layer_layout(TextLayer *tlayer);
+static void _text_layer_invalidate(TextLayer *tlayer);
 
 void text_layer_ctor(TextLayer *tlayer, GRect frame)
 {
@@ -19,6 +21,7 @@ void text_layer_ctor(TextLayer *tlayer, GRect frame)
     tlayer->background_color = GColorWhite;
     tlayer->text_alignment = GTextAlignmentLeft;
     tlayer->font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+    tlayer->layout_cache = (TextLayerLayout) { 0 };
 
     // hook the draw callback to us
     // this way we control the text, bound, pagination etc
@@ -33,7 +36,7 @@ void text_layer_dtor(TextLayer *tlayer)
 // Layer Functions
 TextLayer *text_layer_create(GRect frame)
 {
-    TextLayer* tlayer = app_calloc(1, sizeof(TextLayer));
+    TextLayer* tlayer = app_pool_calloc(AppPoolTextLayer, sizeof(TextLayer));
     text_layer_ctor(tlayer, frame);
     
     return tlayer;
@@ -42,7 +45,12 @@ TextLayer *text_layer_create(GRect frame)
 void text_layer_destroy(TextLayer *layer)
 {
     text_layer_dtor(layer);
-    app_free(layer);
+    app_pool_free(AppPoolTextLayer, layer);
+}
+
+bool text_layer_pool_reserve(uint16_t count)
+{
+    return app_pool_reserve(AppPoolTextLayer, sizeof(TextLayer), count);
 }
 
 Layer *text_layer_get_layer(TextLayer *text_layer)
@@ -53,6 +61,7 @@ Layer *text_layer_get_layer(TextLayer *text_layer)
 void text_layer_set_text(TextLayer *text_layer, const char* text)
 {
     text_layer->text = text;
+    _text_layer_invalidate(text_layer);
     layer_mark_dirty(&text_layer->layer);
 }
 
@@ -76,29 +85,36 @@ void text_layer_set_text_color(TextLayer *text_layer, GColor color)
 void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode)
 {
     text_layer->overflow_mode = line_mode;
+    _text_layer_invalidate(text_layer);
     layer_mark_dirty(&text_layer->layer);
 }
 
 void text_layer_set_font(TextLayer * text_layer, GFont font)
 {   
     text_layer->font = font;
+    _text_layer_invalidate(text_layer);
     layer_mark_dirty(&text_layer->layer);
 }
 
 void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment)
 {
     text_layer->text_alignment = text_alignment;
+    _text_layer_invalidate(text_layer);
     layer_mark_dirty(&text_layer->layer);
 }
 
 GSize text_layer_get_content_size(TextLayer *text_layer)
 {
-    return text_layer->layer.bounds.size;
+    if (!_text_layer_layout(text_layer))
+        return GSize(0, 0);
+
+    return text_layer->layout_cache.content_size;
 }
 
 void text_layer_set_size(TextLayer *text_layer, const GSize max_size)
 {
     text_layer->layer.frame.size = max_size;
+    _text_layer_invalidate(text_layer);
     layer_mark_dirty(&text_layer->layer);
 }
 
@@ -126,6 +142,46 @@ void text_layer_draw(struct Layer *layer, GContext *context)
                        tlayer->text_alignment, &tlayer->text_attributes);
 }
 
+/* Private functions */
+
+static void _text_layer_invalidate(TextLayer *tlayer)
+{
+    tlayer->layout_cache.valid = false;
+}
+
+/*
+ * Measure the text the way it will be drawn: neographics wraps it for us,
+ * so the size always matches what lands on screen. Only done again when
+ * the text, its length or the frame changes, or a setter invalidates it.
+ * Returns false if there is no text to measure
+ */
+static bool _text_layer_layout(TextLayer *tlayer)
+{
+    TextLayerLayout *layout = &tlayer->layout_cache;
+    GSize box = tlayer->layer.frame.size;
+    const char *text = tlayer->text;
+
+    if (!text || !tlayer->font)
+        return false;
+
+    uint16_t length = strlen(text);
+    if (layout->valid &&
+        layout->text == text &&
+        layout->length == length &&
+        layout->box.w == box.w && layout->box.h == box.h)
+        return true;
+
+    layout->text = text;
+    layout->length = length;
+    layout->box = box;
+    layout->content_size = graphics_text_layout_get_content_size(text, tlayer->font,
+                                   GRect(0, 0, box.w, box.h), tlayer->overflow_mode,
+                                   tlayer->text_alignment);
+    layout->valid = true;
+
+    return true;
+}
+
 // TODO paging...
 
 void text_layer_enable_screen_text_flow_and_paging(TextLayer *text_layer, uint8_t inset)
@@ -8,12 +8,26 @@
 
 #include "librebble.h"
 
+/* What neographics measured the text at, and what it measured it from.
+ * The font, alignment and overflow setters invalidate it; the rest is
+ * checked on use. Text edited in place without changing length needs a
+ * text_layer_set_text, as on Pebble */
+typedef struct TextLayerLayout
+{
+    bool valid;
+    const char *text;
+    uint16_t length;
+    GSize box;
+
+    GSize content_size;
+} TextLayerLayout;
+
 typedef struct TextLayer
 {
     Layer layer;
     const char *text;
     GFont font;
-//     GTextLayoutCacheRef layout_cache;
+    TextLayerLayout layout_cache;
     GColor text_color;
     GColor background_color;
     GTextOverflowMode overflow_mode;
@@ -27,6 +41,7 @@ void text_layer_ctor(TextLayer *tlayer, GRect frame);
 
 TextLayer *text_layer_create(GRect frame);
 void text_layer_destroy(TextLayer *text_layer);
+bool text_layer_pool_reserve(uint16_t count);
 
 Layer *text_layer_get_layer(TextLayer *text_layer);
 void text_layer_set_text(TextLayer *text_layer, const char* text);
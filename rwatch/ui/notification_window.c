@@ -11,6 +11,7 @@
 #include "status_bar_layer.h"
 #include "librebble.h"
 #include "ngfxwrap.h"
+#include "display_list.h"
 
 // XXX TODO nofifications don't free memory
 static NotificationWindow *notification_window;
@@ -179,6 +180,7 @@ void notification_window_update_proc(Layer *layer, GContext *ctx)
     GRect rect_bounds = GRect(0, 0 - offset, bounds.size.w, 35);
     graphics_fill_rect(ctx, rect_bounds, 0, GCornerNone);
 #else
+    display_list_abort_record();
     n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS / 2, (-DISPLAY_COLS + 35) - offset), DISPLAY_COLS);
 #endif
     
@@ -219,6 +221,7 @@ void notification_window_update_proc(Layer *layer, GContext *ctx)
     
     // Draw the indicator:
     graphics_context_set_fill_color(ctx, GColorBlack);
+    display_list_abort_record();
     n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS + 2, DISPLAY_ROWS / 2), 10);
     
     // And the other one:
@@ -226,6 +229,7 @@ void notification_window_update_proc(Layer *layer, GContext *ctx)
     if (notification->previous != NULL && notification_window->offset > 0)
     {
         graphics_context_set_fill_color(ctx, notification->previous->color);
+        display_list_abort_record();
         n_graphics_fill_circle(ctx, GPoint(DISPLAY_COLS / 2, DISPLAY_ROWS - 2), 10);
     }
 #endif
@@ -38,7 +38,7 @@ static void _batt_window_load(Window *window)
 static void _batt_window_unload(Window *window)
 {
     notification_battery *nm = (notification_battery *)window->context;
-    noty_free(window->context);
+    notification_release(&nm->data);
 }
 
 static void _draw_battery(Layer *layer, GContext *ctx)
@@ -48,7 +48,7 @@ static void _minimsg_window_load(Window *window)
 static void _minimsg_window_unload(Window *window)
 {
     notification_mini_msg *nm = (notification_mini_msg *)window->context;
-    noty_free(window->context);
+    notification_release(&nm->data);
 }
 
 static void _draw_mini_message(Layer *layer, GContext *ctx)
@@ -62,14 +62,14 @@ static void _notif_man_window_unload(Window *window)
 {
     notification_message *nm = (notification_message *)window->context;
     notification_layer_destroy(nm->notification_layer);
-    
-    
+    /* the message stays in the message list; only the popup goes */
+    notification_release(&nm->data);
 }
 
 static void _nl_back_click_handler(ClickRecognizerRef _, void *context)
 {
     NotificationLayer *nl = (NotificationLayer *)context;
     notification_message *nm = (notification_message *)nl->layer.window->context;
+    /* the layer and context go in the window's unload */
     overlay_window_destroy(nm->data.overlay_window);
-    noty_free(context);
 }
@@ -12,6 +12,8 @@
 #include "animation.h"
 #include "overlay_manager.h"
 #include "notification_manager.h"
+#include "compositor.h"
+#include "utils.h"
 
 static list_head _window_list_head = LIST_HEAD(_window_list_head);
 
@@ -19,18 +21,28 @@ static void _window_unload_proc(Window *window);
 static void _window_load_proc(Window *window);
 
 static bool _anim_direction_left = true;
-static void _animation_util_push_fb(GRect rect, int16_t distance);
+static void _animation_util_push_fb(GRect rect, int16_t dx, int16_t dy);
+static void _fb_copy_row_span(uint8_t *dst_row, const uint8_t *src_row, int16_t x, int16_t w, int16_t dx);
 static void _animation_setup(bool direction_left);
 static void _push_animation_update(Animation *animation,
                                   const AnimationProgress progress);
 
 
+/*
+ * Keep room for count windows, so that creating and destroying them
+ * doesn't touch the heap
+ */
+bool window_pool_reserve(uint16_t count)
+{
+    return app_pool_reserve(AppPoolWindow, sizeof(Window), count);
+}
+
 /*
  * Create a new top level window and all of the contents therein
  */
 Window *window_create(void)
 {
-    Window *window = app_calloc(1, sizeof(Window));
+    Window *window = app_pool_calloc(AppPoolWindow, sizeof(Window));
 
     if (window == NULL)
     {
@@ -66,8 +78,14 @@ void window_set_window_handlers(Window *window, WindowHandlers handlers)
     window->window_handlers = handlers;
 }
 
+/* frame timing for the push animation, reported on teardown */
+static TickType_t _anim_start_ticks;
+static uint16_t _anim_frames;
+
 static void _push_animation_setup(Animation *animation) {
     SYS_LOG("window", APP_LOG_LEVEL_INFO, "Anim window ease in.");
+    _anim_start_ticks = xTaskGetTickCount();
+    _anim_frames = 0;
 }
 
 static void _push_animation_update(Animation *animation,
@@ -77,13 +95,16 @@ static void _push_animation_update(Animation *animation,
     int existx = window->frame.origin.x; 
     int newx, delta; 
      
+    /* The incoming window is redrawn in full at its new x below, so only
+     * the outgoing window's columns are worth moving. Anything shifted
+     * under the incoming window would just be painted over */
     if (*((bool*)animation->context) == true) 
     { 
         newx = ANIM_LERP(DISPLAY_COLS, 0, progress) - 1; 
         delta = (existx - newx);
         if (delta && existx > 0)
         {
-            _animation_util_push_fb(GRect(delta, 0, DISPLAY_COLS - delta, DISPLAY_ROWS), -delta);
+            _animation_util_push_fb(GRect(delta, 0, newx, DISPLAY_ROWS), -delta, 0);
         }
     } 
     else 
@@ -91,15 +112,18 @@ static void _push_animation_update(Animation *animation,
         newx = ANIM_LERP(-DISPLAY_COLS, 0, progress);
         delta = newx - existx;
         if (delta && existx < 0)
-            _animation_util_push_fb(GRect(DISPLAY_COLS + existx + 1, 0, DISPLAY_COLS - delta + 1, DISPLAY_ROWS), delta);
+            _animation_util_push_fb(GRect(DISPLAY_COLS + existx, 0, -newx, DISPLAY_ROWS), delta, 0);
     } 
 
     window->frame.origin.x = newx; 
+    _anim_frames++;
     window_dirty(true); 
 }
 
 static void _push_animation_teardown(Animation *animation) {
-    SYS_LOG("window", APP_LOG_LEVEL_INFO, "Animation finished!");
+    uint32_t elapsed = (xTaskGetTickCount() - _anim_start_ticks) * portTICK_PERIOD_MS;
+    SYS_LOG("window", APP_LOG_LEVEL_INFO, "Animation finished! %d frames in %dms, %dms/frame",
+            _anim_frames, elapsed, _anim_frames ? elapsed / _anim_frames : 0);
     animation_destroy(animation);
 }
 
@@ -290,7 +314,7 @@ void window_destroy(Window *window)
     _window_unload_proc(window);
     window_dtor(window);
     /* and now the window */
-    app_free(window);
+    app_pool_free(AppPoolWindow, window);
     
 
     if (appmanager_get_thread_type() == AppThreadOverlay)
@@ -340,6 +364,19 @@ void window_dirty(bool is_dirty)
     wind->is_render_scheduled = is_dirty;
 }
 
+/*
+ * Does the top window, or any overlay over it, need painting?
+ */
+bool window_is_dirty(void)
+{
+    Window *wind = window_stack_get_top_window();
+    
+    if (wind && wind->is_render_scheduled)
+        return true;
+    
+    return overlay_window_is_dirty();
+}
+
 /* 
  * Draw a window.
  */
@@ -362,16 +399,9 @@ void rbl_window_draw(Window *window)
 
 /*
  * Draw the window, which in general means painting the background
- * and then walking all layers and drawing them
- * 
- * This will draw and lock all further calls behind a mutex.
- * Once the app layers are drawn, a request is sent to the overlay
- * thread to draw itself.
- * After the request is sent, we sleep the thread awaiting wakeup from the 
- * overlay draw completion.
- * Overlay will call to paint out the framebuffer.
- * Display drawing is async, so if a display draw is already in progress, we 
- * also wait for that to complete.
+ * and then walking all layers and drawing them.
+ * The compositor does the work, drawing any overlays over the top and
+ * sending the frame to the display, and only if something changed
  */
 void window_draw(void)
 {
@@ -386,26 +416,7 @@ void window_draw(void)
         return;
     }
     
-    /* Make sure noone else can draw while we are drawing */
-    display_buffer_lock_take(500);
-
-    Window *wind = window_stack_get_top_window();
-
-    if (wind == NULL)
-        return;
-    
-    if (wind->is_render_scheduled)
-        rbl_window_draw(wind);
-
-    wind->is_render_scheduled = false;
-    
-    /* This will be deferred to the overlay renderer */
-    overlay_window_draw();
-    /* Now sit and wait for the overlay to signal done */
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-    /* Unlock the draw mutex */
-    display_buffer_lock_give();
+    compositor_frame();
 }
 
 
@@ -575,50 +586,90 @@ void window_load_click_config(Window *window)
 /* This prob shouldn't be in here, but I feel it doesn't live in 
    animation either */
 
+/* Bytes per framebuffer row. tintin packs 1 bit per pixel,
+ * LSB first, into rows padded out to 20 bytes */
+#ifdef PBL_BW
+#  define FB_ROW_BYTES 20
+#else
+#  define FB_ROW_BYTES DISPLAY_COLS
+#endif
+
 /* 
- * Grab the screenbuffer and push it off the screen left or right by n
- * pixels.
+ * Grab the screenbuffer and push the pixels in rect by dx, dy.
+ * Whole rows are moved at a time. Whatever rect leaves behind is
+ * up to the caller to redraw.
  */
-static void _animation_util_push_fb(GRect rect, int16_t distance)
+static void _animation_util_push_fb(GRect rect, int16_t dx, int16_t dy)
 {
-#ifdef PBL_BW
-#  warning XXX: PBL_BW no push_fb support
-    return;
-#else
     uint8_t *fb = display_get_buffer(); 
     
-    if (rect.origin.x < 0) rect.origin.x = 0;
-    if (rect.origin.x > DISPLAY_COLS) rect.origin.x = DISPLAY_COLS;
-    if (rect.origin.y < 0) rect.origin.y = 0;
-    if (rect.origin.y > DISPLAY_ROWS) rect.origin.y = DISPLAY_ROWS;
-    
-    uint8_t *origin = &fb[(rect.origin.y * DISPLAY_COLS) + rect.origin.x];
-    uint8_t *p;
-    int8_t incr = distance > 0 ? -1 : 1;
+    /* clip so both the source and destination rows are on screen */
+    int16_t y0 = MAX(rect.origin.y, MAX(0, -dy));
+    int16_t y1 = MIN(rect.origin.y + rect.size.h, MIN(DISPLAY_ROWS, DISPLAY_ROWS - dy));
+
+    if (y1 <= y0)
+        return;
 
-    for (int16_t y = 0; y < rect.size.h; y++)
+    /* walk away from the destination so we never read a row we already wrote */
+    if (dy > 0)
     {
-        uint16_t x = distance > 0 ? rect.size.w - 1 : 0;
-       
-        p = origin + (y * DISPLAY_COLS) + x;
-        
-        for (;;)
-        {      
-            *(p + distance) = *p;
-            
-            x += incr;
-            p += incr;
-            
-            if (distance < 0 && x >= rect.size.w)
-                break;
-            else if (distance > 0 && x <= 0)
-                break;
-            
-            if ((p + distance > origin + (DISPLAY_COLS * rect.size.h) + rect.size.w) ||
-                p > origin + DISPLAY_ROWS * DISPLAY_COLS)
-                continue;
-        }
-        
+        for (int16_t y = y1 - 1; y >= y0; y--)
+            _fb_copy_row_span(fb + (y + dy) * FB_ROW_BYTES, fb + y * FB_ROW_BYTES,
+                              rect.origin.x, rect.size.w, dx);
+    }
+    else
+    {
+        for (int16_t y = y0; y < y1; y++)
+            _fb_copy_row_span(fb + (y + dy) * FB_ROW_BYTES, fb + y * FB_ROW_BYTES,
+                              rect.origin.x, rect.size.w, dx);
+    }
+}
+
+#ifdef PBL_BW
+/* 8 pixels starting at pixel bit, which can run off either end of the row */
+static uint8_t _fb_1bit_read8(const uint8_t *row, int16_t bit)
+{
+    int16_t byte = bit >> 3;
+    uint8_t lo = (byte >= 0 && byte < FB_ROW_BYTES) ? row[byte] : 0;
+    uint8_t hi = (byte + 1 >= 0 && byte + 1 < FB_ROW_BYTES) ? row[byte + 1] : 0;
+
+    return ((lo | (hi << 8)) >> (bit & 7)) & 0xFF;
+}
+#endif
+
+/*
+ * Copy pixels [x, x + w) of src_row to dst_row, shifted by dx.
+ * dst_row and src_row may be the same row.
+ */
+static void _fb_copy_row_span(uint8_t *dst_row, const uint8_t *src_row, int16_t x, int16_t w, int16_t dx)
+{
+    int16_t x0 = MAX(x, MAX(0, -dx));
+    int16_t x1 = MIN(x + w, MIN(DISPLAY_COLS, DISPLAY_COLS - dx));
+
+    if (x1 <= x0)
+        return;
+
+#ifdef PBL_BW
+    /* build each destination byte from the 8 source pixels that land in it */
+    int16_t d0 = x0 + dx;
+    int16_t d1 = x1 + dx;
+    int16_t first = d0 >> 3;
+    int16_t last = (d1 - 1) >> 3;
+    int16_t step = (dst_row == src_row && dx > 0) ? -1 : 1;
+    int16_t b = step > 0 ? first : last;
+
+    for (int16_t n = last - first + 1; n > 0; n--, b += step)
+    {
+        uint8_t mask = 0xFF;
+        if (b == first)
+            mask &= 0xFF << (d0 & 7);
+        if (b == last)
+            mask &= 0xFF >> (7 - ((d1 - 1) & 7));
+
+        uint8_t pixels = _fb_1bit_read8(src_row, b * 8 - dx);
+        dst_row[b] = (dst_row[b] & ~mask) | (pixels & mask);
     }
+#else
+    memmove(dst_row + x0 + dx, src_row + x0, x1 - x0);
 #endif
 }
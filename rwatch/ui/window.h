@@ -59,6 +59,7 @@ typedef struct Window
 Window *window_create();
 void window_ctor(Window *window);
 void window_destroy(Window *window);
+bool window_pool_reserve(uint16_t count);
 void window_dtor(Window *window);
 void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider);
 void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider, void *context);
@@ -87,6 +88,7 @@ Window * window_stack_get_top_window(void);
 
 void window_configure(Window *window);
 void window_dirty(bool is_dirty);
+bool window_is_dirty(void);
 void window_draw();
 void rbl_window_draw(Window *window);
 